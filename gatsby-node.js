@@ -12,6 +12,17 @@ exports.onCreateWebpackConfig = ({ actions, getConfig, plugins }) => {
   config.module.rules = [
     {
       oneOf: [
+        // The pthreads build is loaded by URL, since the workers it spawns
+        // have to import its script again
+        {
+          test: /\.js$/,
+          include: [path.join(libPath, 'ffmpeg', 'threads')],
+          type: 'javascript/auto',
+          loader: 'file-loader',
+          options: {
+            name: '[name].[hash:5].[ext]',
+          },
+        },
         // Make sure we use this rule for files in `lib`
         {
           test: /\.js$/,
@@ -4,9 +4,160 @@ set -e
 
 export OPTIMIZE="-Os"
 export PREFIX="/src/build"
-export CFLAGS="${OPTIMIZE} -I${PREFIX}/include"
-export CPPFLAGS="${OPTIMIZE} -I${PREFIX}/include"
-export LDFLAGS="${OPTIMIZE} -L${PREFIX}/lib"
+PROFILE="${PROFILE:-size}"
+VARIANT="default"
+VARIANT_FLAGS=""
+OUTPUT_DIR="."
+ENVIRONMENT="web,worker"
+
+if [[ $PROFILE != size && $PROFILE != speed ]]; then
+  echo "PROFILE must be either size or speed"
+  exit 1
+fi
+
+if [[ $THREADS && $SIMD ]]; then
+  echo "THREADS and SIMD are separate build variants"
+  exit 1
+fi
+
+if [[ $THREADS && $BENCHMARK ]]; then
+  echo "The pthreads variant can't be benchmarked on node"
+  exit 1
+fi
+
+# The pthreads variant needs every library compiled with atomics, so it
+# gets its own prefix and can't be linked into the other bindings
+if [[ $THREADS ]]; then
+  PREFIX="/src/build/threads"
+  VARIANT="threads"
+  VARIANT_FLAGS="-pthread"
+fi
+
+# Both FFmpeg and x264 are built without asm, so the SIMD variant relies on
+# clang autovectorizing their C fallbacks (swscale, h264 idct/mc, x264
+# sad/satd), with the loop and SLP vectorizers turned on explicitly. It keeps
+# the optimization level of the profile, so against the default variant of
+# the same profile the only difference is SIMD. SIMD_REPORT=1 saves clang's
+# optimization records next to the objects and sums up the ones of the hot
+# kernels in simd-report.txt: which of their loops were vectorized, and why
+# the others weren't. The vectorizers of the speed profile run at link time,
+# so the report is only complete for the size profile.
+if [[ $SIMD ]]; then
+  PREFIX="/src/build/simd"
+  VARIANT="simd"
+  VARIANT_FLAGS="-msimd128 -fvectorize -fslp-vectorize"
+
+  if [[ $SIMD_REPORT ]]; then
+    VARIANT="${VARIANT}-report"
+    VARIANT_FLAGS="${VARIANT_FLAGS} -fsave-optimization-record"
+  fi
+fi
+
+# The speed profile trades download size for encode speed, with -O3 and link
+# time optimization across ffmpeg, x264, lame and zlib. LTO objects are
+# bitcode, so they get their own prefix next to the variant's one
+if [[ $PROFILE == speed ]]; then
+  OPTIMIZE="-O3 -flto"
+  PREFIX="${PREFIX}/speed"
+  VARIANT="${VARIANT}-speed"
+fi
+
+# Benchmark builds run on node for scripts/benchmark.js and decode its
+# generated clips, which the shipped builds don't have to. They go to their
+# own prefix and to lib/ffmpeg/bench, and are left out of the manifest.
+if [[ $BENCHMARK ]]; then
+  PREFIX="${PREFIX}/bench"
+  VARIANT="${VARIANT}-bench"
+  OUTPUT_DIR="bench"
+  ENVIRONMENT="node"
+fi
+
+export CFLAGS="${OPTIMIZE} ${VARIANT_FLAGS} -I${PREFIX}/include"
+export CPPFLAGS="${OPTIMIZE} ${VARIANT_FLAGS} -I${PREFIX}/include"
+export LDFLAGS="${OPTIMIZE} ${VARIANT_FLAGS} -L${PREFIX}/lib"
+
+# Sources are shared between variants, objects left by a build with other
+# flags must be removed before building again
+clean_if_variant_changed() {
+  if [[ -f .build-variant && "$(cat .build-variant)" != "$VARIANT" ]]; then
+    emmake make clean || true
+  fi
+  echo "$VARIANT" > .build-variant
+}
+
+# Records a build in manifest.json, which the worker reads to know the builds
+# it can pick from. The hash changes with every rebuild of the module.
+update_manifest() {
+  if [[ $BENCHMARK ]]; then
+    return
+  fi
+
+  node -e '
+    const fs = require("fs")
+    const crypto = require("crypto")
+    const [name, profile, codeFile, jsFile] = process.argv.slice(1)
+    const manifest = JSON.parse(fs.readFileSync("manifest.json", "utf8"))
+    const code = fs.readFileSync(codeFile)
+    manifest.builds[name] = {
+      profile,
+      hash: crypto.createHash("sha256").update(code).digest("hex").slice(0, 16),
+      codeSize: code.length,
+      jsSize: fs.statSync(jsFile).size,
+    }
+    fs.writeFileSync("manifest.json", JSON.stringify(manifest, null, 2) + "\n")
+  ' "$@"
+}
+
+# Sums up the vectorizer remarks of the C fallbacks the SIMD variant counts
+# on, from the optimization records of the last SIMD_REPORT build
+write_simd_report() {
+  find node_modules/ffmpeg node_modules/libx264 -name '*.opt.yaml' |
+    node -e '
+      const fs = require("fs")
+      const KERNELS = {
+        "swscale YUV <-> RGB": /libswscale\/(yuv2rgb|output|input)\.c$/,
+        "h264 IDCT": /libavcodec\/h264idct_template\.c$/,
+        "h264 MC": /libavcodec\/h264(qpel|chroma)_template\.c$/,
+        "x264 SAD/SATD": /common\/pixel\.c$/,
+      }
+      const remarks = Object.fromEntries(
+        Object.keys(KERNELS).map(kernel => [kernel, new Set()])
+      )
+      const files = fs.readFileSync(0, "utf8").split("\n").filter(Boolean)
+      for (const file of files) {
+        for (const record of fs.readFileSync(file, "utf8").split(/^--- !/m)) {
+          const field = name =>
+            (record.match(new RegExp(`^${name}:\\s*(.*)$`, "m")) || [])[1]
+          const pass = field("Pass")
+          if (pass !== "loop-vectorize" && pass !== "slp-vectorizer") {
+            continue
+          }
+          const loc = record.match(/File: (.+?), Line: (\d+)/)
+          const kernel =
+            loc && Object.keys(KERNELS).find(k => KERNELS[k].test(loc[1]))
+          if (!kernel) {
+            continue
+          }
+          const message = record
+            .slice(record.indexOf("Args:"))
+            .split("\n")
+            .map(line => line.match(/^\s+- \w+:\s+(.*)$/))
+            .filter(Boolean)
+            .map(match => match[1].replace(/^\x27|\x27$/g, ""))
+            .join("")
+          remarks[kernel].add(
+            `${record.split("\n")[0]} ${loc[1].replace(/.*\//, "")}:` +
+              `${loc[2]} ${field("Function")}: ${message}`
+          )
+        }
+      }
+      for (const kernel of Object.keys(KERNELS)) {
+        console.log(`# ${kernel}\n`)
+        console.log([...remarks[kernel]].sort().join("\n") || "no remarks")
+        console.log("")
+      }
+    ' > "$1"
+}
 
 test -n "$SKIP_BUILD" || (
   apt-get update
@@ -15,10 +166,10 @@ test -n "$SKIP_BUILD" || (
 
 PROGRAM_NAME=convert
 
-FILTERS=anull,aresample,crop,null,overlay,rotate,scale,transpose,vflip
+FILTERS=anull,aresample,asplit,crop,null,overlay,rotate,scale,split,transpose,vflip
 DEMUXERS=avi,concat,flv,gif,image2,matroska,mov,mp3,mpegps,ogg
 MUXERS=avi,gif,matroska,mov,mp4,mp3,ogg,wav,webm
-ENCODERS=aac,ac3,gif,libx264,libmp3lame,mpeg4,vorbis
+ENCODERS=aac,ac3,gif,libx264,libmp3lame,mjpeg,mpeg4,png,vorbis
 DECODERS="aac,\
 ac3,\
 ass,\
@@ -39,6 +190,11 @@ vp8,\
 vp9,\
 webvtt"
 
+if [[ $BENCHMARK ]]; then
+  DEMUXERS="${DEMUXERS},wav,yuv4mpegpipe"
+  DECODERS="${DECODERS},pcm_s16le,rawvideo"
+fi
+
 FFMPEG_LIBS="libavformat.a,\
 libavcodec.a,\
 libavfilter.a,\
@@ -52,6 +208,7 @@ test -n "$SKIP_BUILD" || test -n "$SKIP_X264" || (
   echo "=========================="
 
   cd node_modules/libx264
+  clean_if_variant_changed
   if ! patch -R -s -f -p1 --dry-run < ../../x264-configure.patch; then
     patch -p1 < ../../x264-configure.patch
   fi
@@ -62,7 +219,8 @@ test -n "$SKIP_BUILD" || test -n "$SKIP_X264" || (
     --disable-cli \
     --enable-shared \
     --disable-opencl \
-    --disable-thread \
+    $([[ $THREADS ]] || echo --disable-thread) \
+    $([[ $PROFILE == speed ]] && echo --enable-lto) \
     --disable-asm \
     --disable-avs \
     --disable-swscale \
@@ -84,6 +242,7 @@ test -n "$SKIP_BUILD" || test -n "$SKIP_LAME" || (
   echo "=========================="
 
   cd node_modules/libmp3lame
+  clean_if_variant_changed
   emconfigure ./configure \
     --prefix=${PREFIX} \
     --host=x86-none-linux \
@@ -107,6 +266,7 @@ test -n "$SKIP_BUILD" || test -n "$SKIP_ZLIB" || (
   echo "=========================="
 
   cd node_modules/zlib
+  clean_if_variant_changed
   emconfigure ./configure --prefix=${PREFIX}
   emmake make -j8
   emmake make install
@@ -122,6 +282,7 @@ test -n "$SKIP_BUILD" || (
   echo "=========================="
 
   cd node_modules/ffmpeg
+  clean_if_variant_changed
   EM_PKG_CONFIG_PATH=${PREFIX}/lib/pkgconfig emconfigure ./configure \
     --prefix=${PREFIX} \
     --cc=emcc \
@@ -131,14 +292,15 @@ test -n "$SKIP_BUILD" || (
     --disable-runtime-cpudetect \
     --disable-asm \
     --disable-fast-unaligned \
-    --disable-pthreads \
+    $([[ $PROFILE == speed ]] && echo --enable-lto) \
+    $([[ $THREADS ]] && echo --enable-pthreads || echo --disable-pthreads) \
     --disable-w32threads \
     --disable-os2threads \
     --disable-debug \
     --disable-all \
     --disable-manpages \
     --disable-stripping \
-    --enable-ffmpeg \
+    --disable-programs \
     --enable-avcodec \
     --enable-avformat \
     --enable-avutil \
@@ -166,11 +328,10 @@ test -n "$SKIP_BUILD" || (
     --enable-gpl \
     --enable-libx264 \
     --enable-zlib \
-    --extra-cflags="-I ${PREFIX}/include" \
-    --extra-ldflags="-L ${PREFIX}/lib"
+    --extra-cflags="${VARIANT_FLAGS} -I ${PREFIX}/include" \
+    --extra-ldflags="${VARIANT_FLAGS} -L ${PREFIX}/lib"
   emmake make -j8
   emmake make install
-  cp ffmpeg ffmpeg.bc
 
   echo "=========================="
   echo "Compiling ffmpeg done"
@@ -179,17 +340,20 @@ test -n "$SKIP_BUILD" || (
 
 EMSCRIPTEN_COMMON_ARGS="--bind \
   ${OPTIMIZE} \
+  ${VARIANT_FLAGS} \
   --closure 1 \
   -s MODULARIZE=1 \
   -s INVOKE_RUN=0 \
   -s EXPORT_NAME=\"ffmpeg\" \
-  -s ENVIRONMENT='web,worker' \
+  -s ENVIRONMENT='${ENVIRONMENT}' \
   --std=c++17 \
   -x c++ \
   -I ${PREFIX}/include \
   --pre-js preamble.js \
-  node_modules/ffmpeg/ffmpeg.bc \
   convert.cpp \
+  -x none \
+  $(eval echo ${PREFIX}/lib/{$FFMPEG_LIBS}) \
+  ${PREFIX}/lib/libz.a \
   ${PREFIX}/lib/libmp3lame.so \
   ${PREFIX}/lib/libx264.so"
 
@@ -201,27 +365,84 @@ echo "=========================="
 echo "Generating bidings"
 echo "=========================="
 (
+  if [[ $THREADS ]]; then
+    echo "******************************************"
+    echo "Generating wasm pthreads bindings"
+    echo "******************************************"
+    # Shared memory can't grow cheaply, so it's reserved upfront like the
+    # asm.js build. A thread can't be spawned while the worker is blocked in
+    # a conversion, so convert.cpp splits the pool between the decoder and
+    # encoders of a job (MAX_CODEC_THREADS each at most, plus x264's
+    # lookahead) and needs to know its size.
+    THREAD_POOL_SIZE=12
+    mkdir -p threads
+    emcc \
+      $EMSCRIPTEN_COMMON_ARGS \
+      -DTHREAD_POOL_SIZE=$THREAD_POOL_SIZE \
+      -s USE_PTHREADS=1 \
+      -s PTHREAD_POOL_SIZE=$THREAD_POOL_SIZE \
+      -s TOTAL_MEMORY=$GB \
+      -o threads/$PROGRAM_NAME.js
+    update_manifest threads $PROFILE threads/$PROGRAM_NAME.wasm \
+      threads/$PROGRAM_NAME.js
+    exit 0
+  fi
+
+  if [[ $SIMD ]]; then
+    echo "******************************************"
+    echo "Generating wasm SIMD bindings"
+    echo "******************************************"
+    mkdir -p $OUTPUT_DIR/simd
+    emcc \
+      $EMSCRIPTEN_COMMON_ARGS \
+      -s ALLOW_MEMORY_GROWTH=1 \
+      -o $OUTPUT_DIR/simd/$PROGRAM_NAME.js
+    update_manifest simd $PROFILE simd/$PROGRAM_NAME.wasm simd/$PROGRAM_NAME.js
+
+    if [[ $SIMD_REPORT ]]; then
+      write_simd_report $OUTPUT_DIR/simd/simd-report.txt
+      echo "Vectorization report written to $OUTPUT_DIR/simd/simd-report.txt"
+    fi
+    exit 0
+  fi
+
   if [[ $ASM_ONLY || $ASM ]]; then
     echo "******************************************"
     echo "Generating asm.js bindings"
     echo "******************************************"
-    mkdir -p asm
+    mkdir -p $OUTPUT_DIR/asm
     emcc \
       $EMSCRIPTEN_COMMON_ARGS \
       -s WASM=0 \
       -s TOTAL_MEMORY=$GB \
       -s USE_CLOSURE_COMPILER=1 \
-      -o asm/$PROGRAM_NAME.js
+      -o $OUTPUT_DIR/asm/$PROGRAM_NAME.js
+    update_manifest asm $PROFILE asm/$PROGRAM_NAME.js.mem asm/$PROGRAM_NAME.js
   fi
 
-  if [[ ! $ASM_ONLY ]]; then
+  # The default variant is built once per profile, side by side, so the worker
+  # can choose between them
+  if [[ ! $ASM_ONLY && $PROFILE == speed ]]; then
+    echo "******************************************"
+    echo "Generating wasm speed bindings"
+    echo "******************************************"
+    mkdir -p $OUTPUT_DIR/speed
+    emcc \
+      $EMSCRIPTEN_COMMON_ARGS \
+      -s ALLOW_MEMORY_GROWTH=1 \
+      -o $OUTPUT_DIR/speed/$PROGRAM_NAME.js
+    update_manifest speed $PROFILE speed/$PROGRAM_NAME.wasm \
+      speed/$PROGRAM_NAME.js
+  elif [[ ! $ASM_ONLY ]]; then
     echo "******************************************"
     echo "Generating wasm bindings"
     echo "******************************************"
+    mkdir -p $OUTPUT_DIR
     emcc \
       $EMSCRIPTEN_COMMON_ARGS \
       -s ALLOW_MEMORY_GROWTH=1 \
-      -o $PROGRAM_NAME.js
+      -o $OUTPUT_DIR/$PROGRAM_NAME.js
+    update_manifest default $PROFILE $PROGRAM_NAME.wasm $PROGRAM_NAME.js
   fi
 )
 echo "=========================="
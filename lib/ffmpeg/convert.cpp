@@ -1,5 +1,18 @@
+#include <emscripten.h>
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#endif
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <malloc.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 
 extern "C" {
 #include "libavcodec/avcodec.h"
@@ -10,537 +23,2953 @@ extern "C" {
 #include "libavutil/pixdesc.h"
 #include "libavutil/display.h"
 #include "libavutil/eval.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/imgutils.h"
+#include "libswscale/swscale.h"
 }
 
 using namespace emscripten;
 using std::string;
 
-extern int main(int argc, char** argv);
+// Appends `value` to a JSON document as a string literal
+void append_json_string(string& json, const char* value) {
+  json += '"';
+
+  for (const char* p = value ? value : ""; *p; p++) {
+    unsigned char c = *p;
+
+    if (c == '"' || c == '\\') {
+      json += '\\';
+      json += c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      json += escaped;
+    } else {
+      json += c;
+    }
+  }
+
+  json += '"';
+}
+
+struct CodecCapability {
+  const char* name;
+  int flag;
+};
+
+const CodecCapability CODEC_CAPABILITIES[] = {
+  { "drawHorizBand", AV_CODEC_CAP_DRAW_HORIZ_BAND },
+  { "dr1", AV_CODEC_CAP_DR1 },
+  { "truncated", AV_CODEC_CAP_TRUNCATED },
+  { "delay", AV_CODEC_CAP_DELAY },
+  { "subFrames", AV_CODEC_CAP_SUBFRAMES },
+  { "experimental", AV_CODEC_CAP_EXPERIMENTAL },
+  { "intraOnly", AV_CODEC_CAP_INTRA_ONLY },
+  { "lossless", AV_CODEC_CAP_LOSSLESS },
+  { "hardware", AV_CODEC_CAP_HARDWARE },
+  { "hybrid", AV_CODEC_CAP_HYBRID },
+};
+
+void append_encoder(string& json, const AVCodec* encoder) {
+  json += "{\"id\":" + std::to_string(encoder->id);
+  json += ",\"type\":" + std::to_string(encoder->type);
+  json += ",\"name\":";
+  append_json_string(json, encoder->name);
+  json += ",\"longName\":";
+  append_json_string(json, encoder->long_name);
+
+  json += ",\"capabilities\":{";
+
+  for (const CodecCapability& capability : CODEC_CAPABILITIES) {
+    if (json.back() != '{')
+      json += ',';
+
+    append_json_string(json, capability.name);
+    json += encoder->capabilities & capability.flag ? ":true" : ":false";
+  }
+
+  json += "},\"pixelFormats\":[";
+
+  for (const AVPixelFormat* p = encoder->pix_fmts; p && *p != AV_PIX_FMT_NONE; p++) {
+    if (p != encoder->pix_fmts)
+      json += ',';
+
+    append_json_string(json, av_get_pix_fmt_name(*p));
+  }
+
+  json += "],\"sampleFormats\":[";
+
+  for (const AVSampleFormat* p = encoder->sample_fmts; p && *p != AV_SAMPLE_FMT_NONE; p++) {
+    if (p != encoder->sample_fmts)
+      json += ',';
+
+    append_json_string(json, av_get_sample_fmt_name(*p));
+  }
+
+  json += "],\"sampleRates\":[";
+
+  for (const int* p = encoder->supported_samplerates; p && *p; p++) {
+    if (p != encoder->supported_samplerates)
+      json += ',';
+
+    json += std::to_string(*p);
+  }
+
+  json += "]}";
+}
+
+// Whether `format` can hold what `encoder` produces. Muxers without a codec
+// tag table can't tell, so only their default codecs are trusted.
+bool is_muxer_compatible(const AVOutputFormat* format, const AVCodec* encoder) {
+  int ret = avformat_query_codec(format, encoder->id, FF_COMPLIANCE_NORMAL);
+
+  if (ret >= 0)
+    return ret == 1;
+
+  return encoder->id == format->video_codec || encoder->id == format->audio_codec;
+}
+
+void append_muxer(string& json, const AVOutputFormat* format, const std::vector<const AVCodec*>& encoders) {
+  json += "{\"name\":";
+  append_json_string(json, format->name);
+  json += ",\"longName\":";
+  append_json_string(json, format->long_name);
+  json += ",\"mimeType\":";
+  append_json_string(json, format->mime_type);
+  json += ",\"extensions\":[";
 
-std::vector<AVCodec> list_encoders() {
-  std::vector<AVCodec> codec_list;
+  string extensions = format->extensions ? format->extensions : "";
+  size_t start = 0;
 
-  void *i = 0;
+  while (start < extensions.size()) {
+    size_t end = extensions.find(',', start);
+
+    if (end == string::npos)
+      end = extensions.size();
+
+    if (start)
+      json += ',';
+
+    append_json_string(json, extensions.substr(start, end - start).c_str());
+    start = end + 1;
+  }
+
+  json += "],\"videoCodec\":" + std::to_string(format->video_codec);
+  json += ",\"audioCodec\":" + std::to_string(format->audio_codec);
+  json += ",\"encoders\":[";
+
+  bool first = true;
+
+  for (const AVCodec* encoder : encoders) {
+    if (!is_muxer_compatible(format, encoder))
+      continue;
+
+    if (!first)
+      json += ',';
+
+    append_json_string(json, encoder->name);
+    first = false;
+  }
+
+  json += "]}";
+}
+
+string build_capabilities() {
+  std::vector<const AVCodec*> encoders;
+  std::set<AVCodecID> codec_ids;
+
+  void* i = 0;
   const AVCodec* codec;
 
   while ((codec = av_codec_iterate(&i)) != NULL) {
-    // skip decoder-only codecs
-    if (avcodec_find_encoder(codec->id) == NULL)
+    // one encoder per codec, the first registered one is the preferred
+    if (av_codec_is_encoder(codec) && codec_ids.insert(codec->id).second)
+      encoders.push_back(codec);
+  }
+
+  string json = "{\"encoders\":[";
+
+  for (const AVCodec* encoder : encoders) {
+    if (encoder != encoders.front())
+      json += ',';
+
+    append_encoder(json, encoder);
+  }
+
+  json += "],\"muxers\":[";
+
+  i = 0;
+  const AVOutputFormat* format;
+
+  while ((format = av_muxer_iterate(&i)) != NULL) {
+    if (json.back() != '[')
+      json += ',';
+
+    append_muxer(json, format, encoders);
+  }
+
+  json += "]}";
+
+  return json;
+}
+
+// The encoders and muxers this build was configured with, which muxer can
+// hold which encoder's output and the formats each encoder takes, as a JSON
+// document. The set is fixed at compile time, so it's only built once.
+string get_capabilities() {
+  static const string capabilities = build_capabilities();
+
+  return capabilities;
+}
+
+struct ExtraOption {
+  string key;
+  string value;
+  // 'v' or 'a' when the option had a stream specifier (e.g. `-b:v`), 0 otherwise
+  char stream_type;
+};
+
+struct ConvertOptions {
+  string output_format;
+  string video_encoder;
+  string audio_encoder;
+  bool verbose = false;
+  // copy the streams that are already encoded with the requested codec
+  bool stream_copy = false;
+  // range of the input to convert, in seconds, negative when open ended
+  double start_time = -1;
+  double end_time = -1;
+  std::vector<ExtraOption> extra_options;
+  // why `extraOptions` couldn't be parsed, which fails the job upfront
+  int extra_options_error = 0;
+  string extra_options_message;
+  // called with the job's progress every `progress_interval` milliseconds
+  val on_progress = val::undefined();
+  double progress_interval = 250;
+  // bytes of wasm heap the job may take, 0 for no limit
+  double memory_limit = 0;
+  // size the video is scaled to, a side left at 0 follows the aspect ratio
+  int width = 0;
+  int height = 0;
+  // bounds the video is scaled down to fit in, keeping its aspect ratio,
+  // unused when width or height are set. 0 leaves a side unbounded.
+  int max_width = 0;
+  int max_height = 0;
+  // x264 preset and tune, e.g. "veryfast" and "film"
+  string preset;
+  string tune;
+  // constant rate factor, from 0 (lossless) to 51, negative when unset.
+  // Encoders other than libx264 get a matching fixed quantizer.
+  int crf = -1;
+  // maximum distance between keyframes, in frames, 0 for the encoder default
+  int gop = 0;
+};
+
+string get_string_option(const val& opts, const char* key) {
+  val value = opts[key];
+
+  if (value.isUndefined() || value.isNull())
+    return "";
+
+  return value.as<string>();
+}
+
+double get_number_option(const val& opts, const char* key, double fallback) {
+  val value = opts[key];
+
+  if (value.isUndefined() || value.isNull())
+    return fallback;
+
+  return value.as<double>();
+}
+
+// Whether `key` is an option of the encoders or muxers, the only ones
+// `extraOptions` are passed to. All of them take a value.
+bool is_known_option(const string& key) {
+  const AVClass* codec_class = avcodec_get_class();
+  const AVClass* format_class = avformat_get_class();
+  int flags = AV_OPT_SEARCH_FAKE_OBJ | AV_OPT_SEARCH_CHILDREN;
+
+  return av_opt_find(&codec_class, key.c_str(), NULL, 0, flags) ||
+    av_opt_find(&format_class, key.c_str(), NULL, 0, flags);
+}
+
+// `extraOptions` keeps the ffmpeg CLI syntax, so it's read as a list of
+// `-key value` options. A key is looked up before its value is taken, since
+// CLI flags like `-an` have none and would shift every option after them.
+void parse_extra_options(const val& extra_options, ConvertOptions& options) {
+  unsigned length = extra_options["length"].as<unsigned>();
+
+  for (unsigned i = 0; i < length; i += 2) {
+    string token = extra_options[i].as<string>();
+
+    if (token.size() < 2 || token[0] != '-') {
+      options.extra_options_error = AVERROR(EINVAL);
+      options.extra_options_message = "Expected an option instead of '" + token + "'";
+      return;
+    }
+
+    ExtraOption option = { token.substr(1), "", 0 };
+    size_t specifier = option.key.find(':');
+
+    if (specifier != string::npos) {
+      option.stream_type = option.key[specifier + 1];
+      option.key = option.key.substr(0, specifier);
+    }
+
+    if (!is_known_option(option.key)) {
+      options.extra_options_error = AVERROR_OPTION_NOT_FOUND;
+      options.extra_options_message = "Unknown option '" + token + "'";
+      return;
+    }
+
+    if (i + 1 >= length) {
+      options.extra_options_error = AVERROR(EINVAL);
+      options.extra_options_message = "Missing the value of option '" + token + "'";
+      return;
+    }
+
+    option.value = extra_options[i + 1].as<string>();
+    options.extra_options.push_back(option);
+  }
+}
+
+// Fails on `extraOptions` that parse_convert_options couldn't make sense of
+int check_extra_options(const ConvertOptions& options) {
+  if (options.extra_options_error < 0)
+    av_log(NULL, AV_LOG_ERROR, "%s\n", options.extra_options_message.c_str());
+
+  return options.extra_options_error;
+}
+
+ConvertOptions parse_convert_options(const val& opts) {
+  ConvertOptions options;
+
+  options.output_format = get_string_option(opts, "outputFormat");
+  options.video_encoder = get_string_option(opts, "videoEncoder");
+  options.audio_encoder = get_string_option(opts, "audioEncoder");
+  options.verbose = opts["verbose"].as<bool>();
+  options.stream_copy = opts["streamCopy"].as<bool>();
+  options.start_time = get_number_option(opts, "startTime", -1);
+  options.end_time = get_number_option(opts, "endTime", -1);
+  options.on_progress = opts["onProgress"];
+  options.progress_interval = get_number_option(opts, "progressInterval", 250);
+  options.memory_limit = get_number_option(opts, "memoryLimit", 0);
+  options.width = (int) get_number_option(opts, "width", 0);
+  options.height = (int) get_number_option(opts, "height", 0);
+  options.max_width = (int) get_number_option(opts, "maxWidth", 0);
+  options.max_height = (int) get_number_option(opts, "maxHeight", 0);
+  options.preset = get_string_option(opts, "preset");
+  options.tune = get_string_option(opts, "tune");
+  options.crf = (int) get_number_option(opts, "crf", -1);
+  options.gop = (int) get_number_option(opts, "gop", 0);
+
+  val extra_options = opts["extraOptions"];
+
+  if (!extra_options.isUndefined() && !extra_options.isNull())
+    parse_extra_options(extra_options, options);
+
+  return options;
+}
+
+// The threads of a codec come out of the job's share of the pthread pool, see
+// get_codec_thread_count, so they can't be set through `extraOptions`. The
+// option counts as taken, it's only ignored.
+AVDictionary* build_dictionary(const std::vector<ExtraOption>& extra_options, char stream_type) {
+  AVDictionary* dict = NULL;
+
+  for (const ExtraOption& option : extra_options) {
+    if (option.stream_type && option.stream_type != stream_type)
+      continue;
+
+    if (option.key == "threads") {
+      av_log(NULL, AV_LOG_WARNING, "Ignoring option 'threads', threads are assigned by the job\n");
       continue;
+    }
 
-    codec_list.push_back(*codec);
+    av_dict_set(&dict, option.key.c_str(), option.value.c_str(), 0);
   }
 
-  return codec_list;
+  return dict;
+}
+
+// Records which of the options build_dictionary passed on were taken, i.e.
+// aren't `remaining` in the dictionary after opening the encoder or muxer.
+void mark_used_options(const std::vector<ExtraOption>& extra_options, char stream_type,
+    const AVDictionary* remaining, std::set<string>& used) {
+  for (const ExtraOption& option : extra_options) {
+    if (option.stream_type && option.stream_type != stream_type)
+      continue;
+
+    if (!av_dict_get(remaining, option.key.c_str(), NULL, 0))
+      used.insert(option.key);
+  }
 }
 
-string get_avcodec_name(const AVCodec& c) {
-  return c.name;
+// The presets of a job as encoder options. Anything also set through
+// `extraOptions` is left to it.
+void apply_video_presets(const ConvertOptions& options, AVCodecContext* enc_ctx, AVDictionary** dict) {
+  if (options.gop > 0)
+    enc_ctx->gop_size = options.gop;
+
+  // libx264 is the only h264 encoder in this build
+  if (enc_ctx->codec_id == AV_CODEC_ID_H264) {
+    if (!options.preset.empty())
+      av_dict_set(dict, "preset", options.preset.c_str(), AV_DICT_DONT_OVERWRITE);
+    if (!options.tune.empty())
+      av_dict_set(dict, "tune", options.tune.c_str(), AV_DICT_DONT_OVERWRITE);
+    if (options.crf >= 0)
+      av_dict_set_int(dict, "crf", options.crf, AV_DICT_DONT_OVERWRITE);
+  } else if (options.crf >= 0) {
+    // maps the crf range onto mpeg4 and mjpeg's quantizer, 1 to 31
+    enc_ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    enc_ctx->global_quality = FF_QP2LAMBDA * (1 + FFMIN(options.crf, 51) * 30 / 51);
+  }
 }
 
-string get_avcodec_long_name(const AVCodec& c) {
-  return c.long_name;
+char get_stream_type(AVMediaType type) {
+  return type == AVMEDIA_TYPE_VIDEO ? 'v' : 'a';
 }
 
-std::vector<AVOutputFormat> list_muxers() {
-  std::vector<AVOutputFormat> muxer_list;
+string error_string(int errnum) {
+  char buf[AV_ERROR_MAX_STRING_SIZE];
 
-  void *i = 0;
-  const AVOutputFormat* format;
+  av_strerror(errnum, buf, sizeof(buf));
 
-  while ((format = av_muxer_iterate(&i)) != NULL) {
-    muxer_list.push_back(*format);
+  return buf;
+}
+
+// Clockwise rotation in degrees the stream has to be displayed with
+double get_rotation(const AVStream* stream) {
+  uint8_t* displaymatrix = av_stream_get_side_data(stream, AV_PKT_DATA_DISPLAYMATRIX, NULL);
+
+  if (!displaymatrix)
+    return 0;
+
+  double theta = -av_display_rotation_get((int32_t*) displaymatrix);
+  theta -= 360 * floor(theta / 360 + 0.9 / 360);
+
+  return theta;
+}
+
+// Mirrors ffmpeg's autorotate, so phone videos don't come out sideways
+string get_rotation_filter(const AVStream* stream) {
+  double theta = get_rotation(stream);
+
+  if (fabs(theta - 90) < 1.0)
+    return "transpose=clock";
+  if (fabs(theta - 180) < 1.0)
+    return "transpose=clock,transpose=clock";
+  if (fabs(theta - 270) < 1.0)
+    return "transpose=cclock";
+  if (fabs(theta) > 1.0)
+    return "rotate=" + std::to_string(theta * M_PI / 180);
+
+  return "null";
+}
+
+AVSampleFormat select_sample_fmt(const AVCodec* codec, AVSampleFormat preferred) {
+  if (!codec->sample_fmts)
+    return preferred;
+
+  for (const AVSampleFormat* p = codec->sample_fmts; *p != AV_SAMPLE_FMT_NONE; p++) {
+    if (*p == preferred)
+      return preferred;
+  }
+
+  return codec->sample_fmts[0];
+}
+
+int select_sample_rate(const AVCodec* codec, int preferred) {
+  if (!codec->supported_samplerates)
+    return preferred;
+
+  int best = 0;
+
+  for (const int* p = codec->supported_samplerates; *p; p++) {
+    if (*p == preferred)
+      return preferred;
+
+    if (!best || abs(preferred - *p) < abs(preferred - best))
+      best = *p;
   }
 
-  return muxer_list;
+  return best;
 }
 
-string get_avformat_name(const AVOutputFormat& format) {
-  return format.name;
+uint64_t select_channel_layout(const AVCodec* codec, uint64_t preferred) {
+  if (!codec->channel_layouts)
+    return preferred;
+
+  int preferred_channels = av_get_channel_layout_nb_channels(preferred);
+  uint64_t best = codec->channel_layouts[0];
+  int best_channels = 0;
+
+  for (const uint64_t* p = codec->channel_layouts; *p; p++) {
+    if (*p == preferred)
+      return preferred;
+
+    int channels = av_get_channel_layout_nb_channels(*p);
+
+    if (channels > best_channels && channels <= preferred_channels) {
+      best = *p;
+      best_channels = channels;
+    }
+  }
+
+  return best;
 }
 
-string get_avformat_long_name(const AVOutputFormat& format) {
-  return format.long_name;
+const int IO_BUFFER_SIZE = 64 * 1024;
+
+// Most reference frames a decoder keeps, h264 and hevc allow for 16
+const int MAX_REFERENCE_FRAMES = 16;
+
+// Packets read between measures of the heap of a job
+const int HEAP_CHECK_INTERVAL = 32;
+
+// Upper bound of threads for each decoder and encoder
+const int MAX_CODEC_THREADS = 4;
+
+// Threads in the pthread pool of the threaded build, passed by build.sh. A
+// job can't spawn any more while it's blocking the worker, so it has to fit
+// in them or it would wait forever.
+#ifndef THREAD_POOL_SIZE
+#define THREAD_POOL_SIZE 12
+#endif
+
+// Threads a codec spawns when opened with `thread_count` of them: none when
+// it runs on the calling thread, plus the lookahead thread of x264 otherwise
+int get_spawned_threads(int thread_count, bool lookahead) {
+  return thread_count > 1 ? thread_count + (lookahead ? 1 : 0) : 0;
 }
 
-string get_avformat_mime_type(const AVOutputFormat& format) {
-  return format.mime_type;
+// Threads for the video decoder and for each of the `encoders` video encoders
+// of a job, which all share the pool. Every encoder is counted with a
+// lookahead thread.
+int get_codec_thread_count(int encoders = 0) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+  int count = FFMIN(emscripten_num_logical_cores(), MAX_CODEC_THREADS);
+
+  while (count > 1 &&
+      get_spawned_threads(count, false) + encoders * get_spawned_threads(count, true) > THREAD_POOL_SIZE)
+    count--;
+
+  return count;
+#else
+  return 1;
+#endif
 }
 
-string get_avformat_extensions(const AVOutputFormat& format) {
-  return format.extensions;
+// Buffers of decoded video frames, one AVBufferPool per buffer size. The pools
+// outlive the decoders, so a job reuses the frames of the previous one instead
+// of growing the heap again, and `trim` lets go of the sizes a job didn't use.
+class FramePool {
+ public:
+  FramePool() = default;
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  ~FramePool() {
+    clear();
+  }
+
+  // get_buffer2 of the video decoders, which must have the pool as `opaque`.
+  // All the planes go in a single pooled buffer laid out like
+  // avcodec_default_get_buffer2 would.
+  static int get_buffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+    if (!(ctx->codec->capabilities & AV_CODEC_CAP_DR1))
+      return avcodec_default_get_buffer2(ctx, frame, flags);
+
+    AVPixelFormat pix_fmt = (AVPixelFormat) frame->format;
+    int height = frame->height;
+    int linesizes[4];
+    int size = get_frame_size(ctx, pix_fmt, frame->width, &height, linesizes);
+
+    if (size < 0)
+      return size;
+
+    AVBufferRef* buf = static_cast<FramePool*>(ctx->opaque)->get(size);
+
+    if (!buf)
+      return AVERROR(ENOMEM);
+
+    av_image_fill_pointers(frame->data, pix_fmt, height, buf->data, linesizes);
+
+    for (int i = 0; i < 4; i++)
+      frame->linesize[i] = linesizes[i];
+
+    frame->buf[0] = buf;
+    frame->extended_data = frame->data;
+
+    return 0;
+  }
+
+  // Size of the pooled buffer of a frame of the decoder, which also fills in
+  // its linesizes and aligns `height` the way the planes are laid out.
+  static int get_frame_size(AVCodecContext* ctx, AVPixelFormat pix_fmt, int width, int* height, int linesizes[4]) {
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    uint8_t* data[4];
+    int ret;
+
+    avcodec_align_dimensions2(ctx, &width, height, linesize_align);
+
+    if ((ret = av_image_fill_linesizes(linesizes, pix_fmt, width)) < 0)
+      return ret;
+
+    for (int i = 0; i < 4; i++)
+      linesizes[i] = FFALIGN(linesizes[i], FFMAX(linesize_align[i], FRAME_ALIGN));
+
+    int size = av_image_fill_pointers(data, pix_fmt, *height, NULL, linesizes);
+
+    if (size < 0)
+      return size;
+
+    // decoders may read a little past the end of the last plane
+    return size + AV_INPUT_BUFFER_PADDING_SIZE;
+  }
+
+  AVBufferRef* get(int size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = pools[size];
+
+    if (!entry.pool && !(entry.pool = av_buffer_pool_init2(size, &entry, &Entry::alloc, NULL)))
+      return NULL;
+
+    entry.used = true;
+
+    return av_buffer_pool_get(entry.pool);
+  }
+
+  // Buffers of `size` bytes the pool already holds, in use or not. A pool
+  // only frees its buffers once it's released, so these are never allocated
+  // again.
+  int allocated(int size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pools.find(size);
+
+    return it == pools.end() ? 0 : it->second.allocated;
+  }
+
+  // Releases the pools that went unused since the last call. Buffers still in
+  // use are freed once they're returned.
+  void trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = pools.begin(); it != pools.end();) {
+      if (it->second.used) {
+        it->second.used = false;
+        ++it;
+      } else {
+        av_buffer_pool_uninit(&it->second.pool);
+        it = pools.erase(it);
+      }
+    }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& entry : pools)
+      av_buffer_pool_uninit(&entry.second.pool);
+
+    pools.clear();
+  }
+
+ private:
+  static constexpr int FRAME_ALIGN = 32;
+
+  struct Entry {
+    AVBufferPool* pool = NULL;
+    bool used = false;
+    int allocated = 0;
+
+    // called through `get`, with the lock held
+    static AVBufferRef* alloc(void* opaque, int size) {
+      AVBufferRef* buf = av_buffer_alloc(size);
+
+      if (buf)
+        static_cast<Entry*>(opaque)->allocated++;
+
+      return buf;
+    }
+  };
+
+  std::mutex mutex;
+  std::map<int, Entry> pools;
+};
+
+// Input read through a custom AVIOContext, either straight from a buffer the
+// caller placed in the wasm heap or in chunks pulled from a JS reader, so the
+// upload never has to be copied into MEMFS.
+class InputSource {
+ public:
+  static std::unique_ptr<InputSource> from_buffer(uintptr_t data, double size) {
+    return std::unique_ptr<InputSource>(
+      new InputSource(reinterpret_cast<const uint8_t*>(data), val::null(), size));
+  }
+
+  // `reader.read(offset, length)` must synchronously return a Uint8Array
+  // with at most `length` bytes starting at `offset`
+  static std::unique_ptr<InputSource> from_reader(val reader, double size) {
+    return std::unique_ptr<InputSource>(new InputSource(NULL, reader, size));
+  }
+
+  static int read_callback(void* opaque, uint8_t* buf, int buf_size) {
+    return static_cast<InputSource*>(opaque)->read(buf, buf_size);
+  }
+
+  static int64_t seek_callback(void* opaque, int64_t offset, int whence) {
+    return static_cast<InputSource*>(opaque)->seek(offset, whence);
+  }
+
+  // bytes of the wasm heap the input takes, none for a reader
+  double get_heap_size() const {
+    return data ? size : 0;
+  }
+
+  // a source is read from the start each time a demuxer opens it, so one
+  // source serves a probe and the conversion after it
+  void rewind() {
+    position = 0;
+  }
+
+ private:
+  InputSource(const uint8_t* data, val reader, double size)
+    : data(data), reader(reader), size(size) {}
+
+  int read(uint8_t* buf, int buf_size) {
+    int64_t remaining = size - position;
+
+    if (remaining <= 0)
+      return AVERROR_EOF;
+
+    int length = (int) FFMIN(remaining, buf_size);
+
+    if (data) {
+      memcpy(buf, data + position, length);
+    } else {
+      val chunk = reader.call<val>("read", (double) position, length);
+      length = FFMIN(chunk["length"].as<int>(), length);
+
+      if (length <= 0)
+        return AVERROR_EOF;
+
+      // copies the chunk from the JS heap right into the AVIO buffer
+      val(typed_memory_view(length, buf)).call<void>("set", chunk.call<val>("subarray", 0, length));
+    }
+
+    position += length;
+
+    return length;
+  }
+
+  int64_t seek(int64_t offset, int whence) {
+    switch (whence & ~AVSEEK_FORCE) {
+      case AVSEEK_SIZE:
+        return size;
+      case SEEK_SET:
+        break;
+      case SEEK_CUR:
+        offset += position;
+        break;
+      case SEEK_END:
+        offset += size;
+        break;
+      default:
+        return AVERROR(EINVAL);
+    }
+
+    if (offset < 0 || offset > size)
+      return AVERROR(EINVAL);
+
+    position = offset;
+
+    return position;
+  }
+
+  const uint8_t* data;
+  val reader;
+  int64_t size;
+  int64_t position = 0;
+};
+
+// Output written through a custom AVIOContext. By default the muxed file is
+// collected in a seekable heap buffer; with a chunk callback every write is
+// handed to JS as soon as it's produced instead, and the muxer is switched to
+// a fragmented layout since it won't be able to seek back.
+class OutputSink {
+ public:
+  static std::unique_ptr<OutputSink> to_buffer() {
+    return std::unique_ptr<OutputSink>(new OutputSink(val::null()));
+  }
+
+  // `on_chunk` receives a view into the wasm heap, so it must copy the data
+  // before returning
+  static std::unique_ptr<OutputSink> to_callback(val on_chunk) {
+    return std::unique_ptr<OutputSink>(new OutputSink(on_chunk));
+  }
+
+  static int write_callback(void* opaque, uint8_t* buf, int buf_size) {
+    return static_cast<OutputSink*>(opaque)->write(buf, buf_size);
+  }
+
+  static int64_t seek_callback(void* opaque, int64_t offset, int whence) {
+    return static_cast<OutputSink*>(opaque)->seek(offset, whence);
+  }
+
+  bool is_streaming() const {
+    return !on_chunk.isNull();
+  }
+
+  val data() const {
+    return val(typed_memory_view(buffer.size(), buffer.data()));
+  }
+
+  double bytes_written() const {
+    return written;
+  }
+
+ private:
+  OutputSink(val on_chunk) : on_chunk(on_chunk) {}
+
+  int write(uint8_t* buf, int buf_size) {
+    written += buf_size;
+
+    if (is_streaming()) {
+      on_chunk(val(typed_memory_view(buf_size, buf)));
+      return buf_size;
+    }
+
+    if (position + buf_size > (int64_t) buffer.size())
+      buffer.resize(position + buf_size);
+
+    memcpy(buffer.data() + position, buf, buf_size);
+    position += buf_size;
+
+    return buf_size;
+  }
+
+  int64_t seek(int64_t offset, int whence) {
+    int64_t size = buffer.size();
+
+    switch (whence & ~AVSEEK_FORCE) {
+      case AVSEEK_SIZE:
+        return size;
+      case SEEK_SET:
+        break;
+      case SEEK_CUR:
+        offset += position;
+        break;
+      case SEEK_END:
+        offset += size;
+        break;
+      default:
+        return AVERROR(EINVAL);
+    }
+
+    if (offset < 0)
+      return AVERROR(EINVAL);
+
+    position = offset;
+
+    return position;
+  }
+
+  val on_chunk;
+  std::vector<uint8_t> buffer;
+  int64_t position = 0;
+  int64_t written = 0;
+};
+
+// Opens a demuxer reading `input` through a custom AVIOContext. Whatever got
+// allocated is left in `fmt_ctx` and `io` even on failure, for
+// close_input_context to release.
+int open_input_context(InputSource& input, AVFormatContext** fmt_ctx, AVIOContext** io, AVDictionary** format_opts = NULL) {
+  uint8_t* buffer = (uint8_t*) av_malloc(IO_BUFFER_SIZE);
+
+  if (!buffer)
+    return AVERROR(ENOMEM);
+
+  input.rewind();
+
+  *io = avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, &input,
+    &InputSource::read_callback, NULL, &InputSource::seek_callback);
+
+  if (!*io) {
+    av_free(buffer);
+    return AVERROR(ENOMEM);
+  }
+
+  if (!(*fmt_ctx = avformat_alloc_context()))
+    return AVERROR(ENOMEM);
+
+  (*fmt_ctx)->pb = *io;
+
+  int ret;
+
+  if ((ret = avformat_open_input(fmt_ctx, NULL, NULL, format_opts)) < 0) {
+    av_log(NULL, AV_LOG_ERROR, "Cannot open input file\n");
+    return ret;
+  }
+
+  if ((ret = avformat_find_stream_info(*fmt_ctx, NULL)) < 0) {
+    av_log(NULL, AV_LOG_ERROR, "Cannot find stream information\n");
+    return ret;
+  }
+
+  return 0;
 }
 
-EMSCRIPTEN_BINDINGS(ffmpeg) {
-  register_vector<AVCodec>("VectorAVCodec");
-  register_vector<AVOutputFormat>("VectorAVOutputFormat");
-
-  enum_<AVMediaType>("AVMediaType")
-    .value("AVMEDIA_TYPE_UNKNOWN", AVMEDIA_TYPE_UNKNOWN)
-    .value("AVMEDIA_TYPE_VIDEO", AVMEDIA_TYPE_VIDEO)
-    .value("AVMEDIA_TYPE_AUDIO", AVMEDIA_TYPE_AUDIO)
-    .value("AVMEDIA_TYPE_DATA", AVMEDIA_TYPE_DATA)
-    .value("AVMEDIA_TYPE_SUBTITLE", AVMEDIA_TYPE_SUBTITLE)
-    .value("AVMEDIA_TYPE_ATTACHMENT", AVMEDIA_TYPE_ATTACHMENT)
-    .value("AVMEDIA_TYPE_NB", AVMEDIA_TYPE_NB);
-
-  class_<AVCodec>("AVCodec")
-    .property("id", &AVCodec::id)
-    .property("type", &AVCodec::type)
-    .property("name", &get_avcodec_name)
-    .property("long_name", &get_avcodec_long_name)
-    .property("capabilities", &AVCodec::capabilities);
-
-  class_<AVOutputFormat>("AVOutputFormat")
-    .property("name", &get_avformat_name)
-    .property("long_name", &get_avformat_long_name)
-    .property("mime_type", &get_avformat_mime_type)
-    .property("extensions", &get_avformat_extensions)
-    .property("audio_codec", &AVOutputFormat::audio_codec)
-    .property("video_codec", &AVOutputFormat::video_codec);
-
-  constant("AV_CODEC_CAP_DRAW_HORIZ_BAND", AV_CODEC_CAP_DRAW_HORIZ_BAND);
-  constant("AV_CODEC_CAP_DR1", AV_CODEC_CAP_DR1);
-  constant("AV_CODEC_CAP_TRUNCATED", AV_CODEC_CAP_TRUNCATED);
-  constant("AV_CODEC_CAP_DELAY", AV_CODEC_CAP_DELAY);
-  constant("AV_CODEC_CAP_SMALL_LAST_FRAME", AV_CODEC_CAP_SMALL_LAST_FRAME);
-  constant("AV_CODEC_CAP_SUBFRAMES", AV_CODEC_CAP_SUBFRAMES);
-  constant("AV_CODEC_CAP_EXPERIMENTAL", AV_CODEC_CAP_EXPERIMENTAL);
-  constant("AV_CODEC_CAP_CHANNEL_CONF", AV_CODEC_CAP_CHANNEL_CONF);
-  constant("AV_CODEC_CAP_FRAME_THREADS", AV_CODEC_CAP_FRAME_THREADS);
-  constant("AV_CODEC_CAP_SLICE_THREADS", AV_CODEC_CAP_SLICE_THREADS);
-  constant("AV_CODEC_CAP_PARAM_CHANGE", AV_CODEC_CAP_PARAM_CHANGE);
-  constant("AV_CODEC_CAP_AUTO_THREADS", AV_CODEC_CAP_AUTO_THREADS);
-  constant("AV_CODEC_CAP_VARIABLE_FRAME_SIZE", AV_CODEC_CAP_VARIABLE_FRAME_SIZE);
-  constant("AV_CODEC_CAP_AVOID_PROBING", AV_CODEC_CAP_AVOID_PROBING);
-  constant("AV_CODEC_CAP_INTRA_ONLY", AV_CODEC_CAP_INTRA_ONLY);
-  constant("AV_CODEC_CAP_LOSSLESS", AV_CODEC_CAP_LOSSLESS);
-  constant("AV_CODEC_CAP_HARDWARE", AV_CODEC_CAP_HARDWARE);
-  constant("AV_CODEC_CAP_HYBRID", AV_CODEC_CAP_HYBRID);
-  constant("AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE", AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE);
-
-  function("list_encoders", &list_encoders);
-  function("list_muxers", &list_muxers);
-
-#pragma region
-  enum_<AVCodecID>("AVCodecID")
-    .value("AV_CODEC_ID_NONE", AV_CODEC_ID_NONE)
-    .value("AV_CODEC_ID_MPEG1VIDEO", AV_CODEC_ID_MPEG1VIDEO)
-    .value("AV_CODEC_ID_MPEG2VIDEO", AV_CODEC_ID_MPEG2VIDEO)
-    .value("AV_CODEC_ID_H261", AV_CODEC_ID_H261)
-    .value("AV_CODEC_ID_H263", AV_CODEC_ID_H263)
-    .value("AV_CODEC_ID_RV10", AV_CODEC_ID_RV10)
-    .value("AV_CODEC_ID_RV20", AV_CODEC_ID_RV20)
-    .value("AV_CODEC_ID_MJPEG", AV_CODEC_ID_MJPEG)
-    .value("AV_CODEC_ID_MJPEGB", AV_CODEC_ID_MJPEGB)
-    .value("AV_CODEC_ID_LJPEG", AV_CODEC_ID_LJPEG)
-    .value("AV_CODEC_ID_SP5X", AV_CODEC_ID_SP5X)
-    .value("AV_CODEC_ID_JPEGLS", AV_CODEC_ID_JPEGLS)
-    .value("AV_CODEC_ID_MPEG4", AV_CODEC_ID_MPEG4)
-    .value("AV_CODEC_ID_RAWVIDEO", AV_CODEC_ID_RAWVIDEO)
-    .value("AV_CODEC_ID_MSMPEG4V1", AV_CODEC_ID_MSMPEG4V1)
-    .value("AV_CODEC_ID_MSMPEG4V2", AV_CODEC_ID_MSMPEG4V2)
-    .value("AV_CODEC_ID_MSMPEG4V3", AV_CODEC_ID_MSMPEG4V3)
-    .value("AV_CODEC_ID_WMV1", AV_CODEC_ID_WMV1)
-    .value("AV_CODEC_ID_WMV2", AV_CODEC_ID_WMV2)
-    .value("AV_CODEC_ID_H263P", AV_CODEC_ID_H263P)
-    .value("AV_CODEC_ID_H263I", AV_CODEC_ID_H263I)
-    .value("AV_CODEC_ID_FLV1", AV_CODEC_ID_FLV1)
-    .value("AV_CODEC_ID_SVQ1", AV_CODEC_ID_SVQ1)
-    .value("AV_CODEC_ID_SVQ3", AV_CODEC_ID_SVQ3)
-    .value("AV_CODEC_ID_DVVIDEO", AV_CODEC_ID_DVVIDEO)
-    .value("AV_CODEC_ID_HUFFYUV", AV_CODEC_ID_HUFFYUV)
-    .value("AV_CODEC_ID_CYUV", AV_CODEC_ID_CYUV)
-    .value("AV_CODEC_ID_H264", AV_CODEC_ID_H264)
-    .value("AV_CODEC_ID_INDEO3", AV_CODEC_ID_INDEO3)
-    .value("AV_CODEC_ID_VP3", AV_CODEC_ID_VP3)
-    .value("AV_CODEC_ID_THEORA", AV_CODEC_ID_THEORA)
-    .value("AV_CODEC_ID_ASV1", AV_CODEC_ID_ASV1)
-    .value("AV_CODEC_ID_ASV2", AV_CODEC_ID_ASV2)
-    .value("AV_CODEC_ID_FFV1", AV_CODEC_ID_FFV1)
-    .value("AV_CODEC_ID_4XM", AV_CODEC_ID_4XM)
-    .value("AV_CODEC_ID_VCR1", AV_CODEC_ID_VCR1)
-    .value("AV_CODEC_ID_CLJR", AV_CODEC_ID_CLJR)
-    .value("AV_CODEC_ID_MDEC", AV_CODEC_ID_MDEC)
-    .value("AV_CODEC_ID_ROQ", AV_CODEC_ID_ROQ)
-    .value("AV_CODEC_ID_INTERPLAY_VIDEO", AV_CODEC_ID_INTERPLAY_VIDEO)
-    .value("AV_CODEC_ID_XAN_WC3", AV_CODEC_ID_XAN_WC3)
-    .value("AV_CODEC_ID_XAN_WC4", AV_CODEC_ID_XAN_WC4)
-    .value("AV_CODEC_ID_RPZA", AV_CODEC_ID_RPZA)
-    .value("AV_CODEC_ID_CINEPAK", AV_CODEC_ID_CINEPAK)
-    .value("AV_CODEC_ID_WS_VQA", AV_CODEC_ID_WS_VQA)
-    .value("AV_CODEC_ID_MSRLE", AV_CODEC_ID_MSRLE)
-    .value("AV_CODEC_ID_MSVIDEO1", AV_CODEC_ID_MSVIDEO1)
-    .value("AV_CODEC_ID_IDCIN", AV_CODEC_ID_IDCIN)
-    .value("AV_CODEC_ID_8BPS", AV_CODEC_ID_8BPS)
-    .value("AV_CODEC_ID_SMC", AV_CODEC_ID_SMC)
-    .value("AV_CODEC_ID_FLIC", AV_CODEC_ID_FLIC)
-    .value("AV_CODEC_ID_TRUEMOTION1", AV_CODEC_ID_TRUEMOTION1)
-    .value("AV_CODEC_ID_VMDVIDEO", AV_CODEC_ID_VMDVIDEO)
-    .value("AV_CODEC_ID_MSZH", AV_CODEC_ID_MSZH)
-    .value("AV_CODEC_ID_ZLIB", AV_CODEC_ID_ZLIB)
-    .value("AV_CODEC_ID_QTRLE", AV_CODEC_ID_QTRLE)
-    .value("AV_CODEC_ID_TSCC", AV_CODEC_ID_TSCC)
-    .value("AV_CODEC_ID_ULTI", AV_CODEC_ID_ULTI)
-    .value("AV_CODEC_ID_QDRAW", AV_CODEC_ID_QDRAW)
-    .value("AV_CODEC_ID_VIXL", AV_CODEC_ID_VIXL)
-    .value("AV_CODEC_ID_QPEG", AV_CODEC_ID_QPEG)
-    .value("AV_CODEC_ID_PNG", AV_CODEC_ID_PNG)
-    .value("AV_CODEC_ID_PPM", AV_CODEC_ID_PPM)
-    .value("AV_CODEC_ID_PBM", AV_CODEC_ID_PBM)
-    .value("AV_CODEC_ID_PGM", AV_CODEC_ID_PGM)
-    .value("AV_CODEC_ID_PGMYUV", AV_CODEC_ID_PGMYUV)
-    .value("AV_CODEC_ID_PAM", AV_CODEC_ID_PAM)
-    .value("AV_CODEC_ID_FFVHUFF", AV_CODEC_ID_FFVHUFF)
-    .value("AV_CODEC_ID_RV30", AV_CODEC_ID_RV30)
-    .value("AV_CODEC_ID_RV40", AV_CODEC_ID_RV40)
-    .value("AV_CODEC_ID_VC1", AV_CODEC_ID_VC1)
-    .value("AV_CODEC_ID_WMV3", AV_CODEC_ID_WMV3)
-    .value("AV_CODEC_ID_LOCO", AV_CODEC_ID_LOCO)
-    .value("AV_CODEC_ID_WNV1", AV_CODEC_ID_WNV1)
-    .value("AV_CODEC_ID_AASC", AV_CODEC_ID_AASC)
-    .value("AV_CODEC_ID_INDEO2", AV_CODEC_ID_INDEO2)
-    .value("AV_CODEC_ID_FRAPS", AV_CODEC_ID_FRAPS)
-    .value("AV_CODEC_ID_TRUEMOTION2", AV_CODEC_ID_TRUEMOTION2)
-    .value("AV_CODEC_ID_BMP", AV_CODEC_ID_BMP)
-    .value("AV_CODEC_ID_CSCD", AV_CODEC_ID_CSCD)
-    .value("AV_CODEC_ID_MMVIDEO", AV_CODEC_ID_MMVIDEO)
-    .value("AV_CODEC_ID_ZMBV", AV_CODEC_ID_ZMBV)
-    .value("AV_CODEC_ID_AVS", AV_CODEC_ID_AVS)
-    .value("AV_CODEC_ID_SMACKVIDEO", AV_CODEC_ID_SMACKVIDEO)
-    .value("AV_CODEC_ID_NUV", AV_CODEC_ID_NUV)
-    .value("AV_CODEC_ID_KMVC", AV_CODEC_ID_KMVC)
-    .value("AV_CODEC_ID_FLASHSV", AV_CODEC_ID_FLASHSV)
-    .value("AV_CODEC_ID_CAVS", AV_CODEC_ID_CAVS)
-    .value("AV_CODEC_ID_JPEG2000", AV_CODEC_ID_JPEG2000)
-    .value("AV_CODEC_ID_VMNC", AV_CODEC_ID_VMNC)
-    .value("AV_CODEC_ID_VP5", AV_CODEC_ID_VP5)
-    .value("AV_CODEC_ID_VP6", AV_CODEC_ID_VP6)
-    .value("AV_CODEC_ID_VP6F", AV_CODEC_ID_VP6F)
-    .value("AV_CODEC_ID_TARGA", AV_CODEC_ID_TARGA)
-    .value("AV_CODEC_ID_DSICINVIDEO", AV_CODEC_ID_DSICINVIDEO)
-    .value("AV_CODEC_ID_TIERTEXSEQVIDEO", AV_CODEC_ID_TIERTEXSEQVIDEO)
-    .value("AV_CODEC_ID_TIFF", AV_CODEC_ID_TIFF)
-    .value("AV_CODEC_ID_GIF", AV_CODEC_ID_GIF)
-    .value("AV_CODEC_ID_DXA", AV_CODEC_ID_DXA)
-    .value("AV_CODEC_ID_DNXHD", AV_CODEC_ID_DNXHD)
-    .value("AV_CODEC_ID_THP", AV_CODEC_ID_THP)
-    .value("AV_CODEC_ID_SGI", AV_CODEC_ID_SGI)
-    .value("AV_CODEC_ID_C93", AV_CODEC_ID_C93)
-    .value("AV_CODEC_ID_BETHSOFTVID", AV_CODEC_ID_BETHSOFTVID)
-    .value("AV_CODEC_ID_PTX", AV_CODEC_ID_PTX)
-    .value("AV_CODEC_ID_TXD", AV_CODEC_ID_TXD)
-    .value("AV_CODEC_ID_VP6A", AV_CODEC_ID_VP6A)
-    .value("AV_CODEC_ID_AMV", AV_CODEC_ID_AMV)
-    .value("AV_CODEC_ID_VB", AV_CODEC_ID_VB)
-    .value("AV_CODEC_ID_PCX", AV_CODEC_ID_PCX)
-    .value("AV_CODEC_ID_SUNRAST", AV_CODEC_ID_SUNRAST)
-    .value("AV_CODEC_ID_INDEO4", AV_CODEC_ID_INDEO4)
-    .value("AV_CODEC_ID_INDEO5", AV_CODEC_ID_INDEO5)
-    .value("AV_CODEC_ID_MIMIC", AV_CODEC_ID_MIMIC)
-    .value("AV_CODEC_ID_RL2", AV_CODEC_ID_RL2)
-    .value("AV_CODEC_ID_ESCAPE124", AV_CODEC_ID_ESCAPE124)
-    .value("AV_CODEC_ID_DIRAC", AV_CODEC_ID_DIRAC)
-    .value("AV_CODEC_ID_BFI", AV_CODEC_ID_BFI)
-    .value("AV_CODEC_ID_CMV", AV_CODEC_ID_CMV)
-    .value("AV_CODEC_ID_MOTIONPIXELS", AV_CODEC_ID_MOTIONPIXELS)
-    .value("AV_CODEC_ID_TGV", AV_CODEC_ID_TGV)
-    .value("AV_CODEC_ID_TGQ", AV_CODEC_ID_TGQ)
-    .value("AV_CODEC_ID_TQI", AV_CODEC_ID_TQI)
-    .value("AV_CODEC_ID_AURA", AV_CODEC_ID_AURA)
-    .value("AV_CODEC_ID_AURA2", AV_CODEC_ID_AURA2)
-    .value("AV_CODEC_ID_V210X", AV_CODEC_ID_V210X)
-    .value("AV_CODEC_ID_TMV", AV_CODEC_ID_TMV)
-    .value("AV_CODEC_ID_V210", AV_CODEC_ID_V210)
-    .value("AV_CODEC_ID_DPX", AV_CODEC_ID_DPX)
-    .value("AV_CODEC_ID_MAD", AV_CODEC_ID_MAD)
-    .value("AV_CODEC_ID_FRWU", AV_CODEC_ID_FRWU)
-    .value("AV_CODEC_ID_FLASHSV2", AV_CODEC_ID_FLASHSV2)
-    .value("AV_CODEC_ID_CDGRAPHICS", AV_CODEC_ID_CDGRAPHICS)
-    .value("AV_CODEC_ID_R210", AV_CODEC_ID_R210)
-    .value("AV_CODEC_ID_ANM", AV_CODEC_ID_ANM)
-    .value("AV_CODEC_ID_BINKVIDEO", AV_CODEC_ID_BINKVIDEO)
-    .value("AV_CODEC_ID_IFF_ILBM", AV_CODEC_ID_IFF_ILBM)
-    .value("AV_CODEC_ID_KGV1", AV_CODEC_ID_KGV1)
-    .value("AV_CODEC_ID_YOP", AV_CODEC_ID_YOP)
-    .value("AV_CODEC_ID_VP8", AV_CODEC_ID_VP8)
-    .value("AV_CODEC_ID_PICTOR", AV_CODEC_ID_PICTOR)
-    .value("AV_CODEC_ID_ANSI", AV_CODEC_ID_ANSI)
-    .value("AV_CODEC_ID_A64_MULTI", AV_CODEC_ID_A64_MULTI)
-    .value("AV_CODEC_ID_A64_MULTI5", AV_CODEC_ID_A64_MULTI5)
-    .value("AV_CODEC_ID_R10K", AV_CODEC_ID_R10K)
-    .value("AV_CODEC_ID_MXPEG", AV_CODEC_ID_MXPEG)
-    .value("AV_CODEC_ID_LAGARITH", AV_CODEC_ID_LAGARITH)
-    .value("AV_CODEC_ID_PRORES", AV_CODEC_ID_PRORES)
-    .value("AV_CODEC_ID_JV", AV_CODEC_ID_JV)
-    .value("AV_CODEC_ID_DFA", AV_CODEC_ID_DFA)
-    .value("AV_CODEC_ID_WMV3IMAGE", AV_CODEC_ID_WMV3IMAGE)
-    .value("AV_CODEC_ID_VC1IMAGE", AV_CODEC_ID_VC1IMAGE)
-    .value("AV_CODEC_ID_UTVIDEO", AV_CODEC_ID_UTVIDEO)
-    .value("AV_CODEC_ID_BMV_VIDEO", AV_CODEC_ID_BMV_VIDEO)
-    .value("AV_CODEC_ID_VBLE", AV_CODEC_ID_VBLE)
-    .value("AV_CODEC_ID_DXTORY", AV_CODEC_ID_DXTORY)
-    .value("AV_CODEC_ID_V410", AV_CODEC_ID_V410)
-    .value("AV_CODEC_ID_XWD", AV_CODEC_ID_XWD)
-    .value("AV_CODEC_ID_CDXL", AV_CODEC_ID_CDXL)
-    .value("AV_CODEC_ID_XBM", AV_CODEC_ID_XBM)
-    .value("AV_CODEC_ID_ZEROCODEC", AV_CODEC_ID_ZEROCODEC)
-    .value("AV_CODEC_ID_MSS1", AV_CODEC_ID_MSS1)
-    .value("AV_CODEC_ID_MSA1", AV_CODEC_ID_MSA1)
-    .value("AV_CODEC_ID_TSCC2", AV_CODEC_ID_TSCC2)
-    .value("AV_CODEC_ID_MTS2", AV_CODEC_ID_MTS2)
-    .value("AV_CODEC_ID_CLLC", AV_CODEC_ID_CLLC)
-    .value("AV_CODEC_ID_MSS2", AV_CODEC_ID_MSS2)
-    .value("AV_CODEC_ID_VP9", AV_CODEC_ID_VP9)
-    .value("AV_CODEC_ID_AIC", AV_CODEC_ID_AIC)
-    .value("AV_CODEC_ID_ESCAPE130", AV_CODEC_ID_ESCAPE130)
-    .value("AV_CODEC_ID_G2M", AV_CODEC_ID_G2M)
-    .value("AV_CODEC_ID_WEBP", AV_CODEC_ID_WEBP)
-    .value("AV_CODEC_ID_HNM4_VIDEO", AV_CODEC_ID_HNM4_VIDEO)
-    .value("AV_CODEC_ID_HEVC", AV_CODEC_ID_HEVC)
-    .value("AV_CODEC_ID_FIC", AV_CODEC_ID_FIC)
-    .value("AV_CODEC_ID_ALIAS_PIX", AV_CODEC_ID_ALIAS_PIX)
-    .value("AV_CODEC_ID_BRENDER_PIX", AV_CODEC_ID_BRENDER_PIX)
-    .value("AV_CODEC_ID_PAF_VIDEO", AV_CODEC_ID_PAF_VIDEO)
-    .value("AV_CODEC_ID_EXR", AV_CODEC_ID_EXR)
-    .value("AV_CODEC_ID_VP7", AV_CODEC_ID_VP7)
-    .value("AV_CODEC_ID_SANM", AV_CODEC_ID_SANM)
-    .value("AV_CODEC_ID_SGIRLE", AV_CODEC_ID_SGIRLE)
-    .value("AV_CODEC_ID_MVC1", AV_CODEC_ID_MVC1)
-    .value("AV_CODEC_ID_MVC2", AV_CODEC_ID_MVC2)
-    .value("AV_CODEC_ID_HQX", AV_CODEC_ID_HQX)
-    .value("AV_CODEC_ID_TDSC", AV_CODEC_ID_TDSC)
-    .value("AV_CODEC_ID_HQ_HQA", AV_CODEC_ID_HQ_HQA)
-    .value("AV_CODEC_ID_HAP", AV_CODEC_ID_HAP)
-    .value("AV_CODEC_ID_DDS", AV_CODEC_ID_DDS)
-    .value("AV_CODEC_ID_DXV", AV_CODEC_ID_DXV)
-    .value("AV_CODEC_ID_SCREENPRESSO", AV_CODEC_ID_SCREENPRESSO)
-    .value("AV_CODEC_ID_RSCC", AV_CODEC_ID_RSCC)
-    .value("AV_CODEC_ID_AVS2", AV_CODEC_ID_AVS2)
-    .value("AV_CODEC_ID_Y41P", AV_CODEC_ID_Y41P)
-    .value("AV_CODEC_ID_AVRP", AV_CODEC_ID_AVRP)
-    .value("AV_CODEC_ID_012V", AV_CODEC_ID_012V)
-    .value("AV_CODEC_ID_AVUI", AV_CODEC_ID_AVUI)
-    .value("AV_CODEC_ID_AYUV", AV_CODEC_ID_AYUV)
-    .value("AV_CODEC_ID_TARGA_Y216", AV_CODEC_ID_TARGA_Y216)
-    .value("AV_CODEC_ID_V308", AV_CODEC_ID_V308)
-    .value("AV_CODEC_ID_V408", AV_CODEC_ID_V408)
-    .value("AV_CODEC_ID_YUV4", AV_CODEC_ID_YUV4)
-    .value("AV_CODEC_ID_AVRN", AV_CODEC_ID_AVRN)
-    .value("AV_CODEC_ID_CPIA", AV_CODEC_ID_CPIA)
-    .value("AV_CODEC_ID_XFACE", AV_CODEC_ID_XFACE)
-    .value("AV_CODEC_ID_SNOW", AV_CODEC_ID_SNOW)
-    .value("AV_CODEC_ID_SMVJPEG", AV_CODEC_ID_SMVJPEG)
-    .value("AV_CODEC_ID_APNG", AV_CODEC_ID_APNG)
-    .value("AV_CODEC_ID_DAALA", AV_CODEC_ID_DAALA)
-    .value("AV_CODEC_ID_CFHD", AV_CODEC_ID_CFHD)
-    .value("AV_CODEC_ID_TRUEMOTION2RT", AV_CODEC_ID_TRUEMOTION2RT)
-    .value("AV_CODEC_ID_M101", AV_CODEC_ID_M101)
-    .value("AV_CODEC_ID_MAGICYUV", AV_CODEC_ID_MAGICYUV)
-    .value("AV_CODEC_ID_SHEERVIDEO", AV_CODEC_ID_SHEERVIDEO)
-    .value("AV_CODEC_ID_YLC", AV_CODEC_ID_YLC)
-    .value("AV_CODEC_ID_PSD", AV_CODEC_ID_PSD)
-    .value("AV_CODEC_ID_PIXLET", AV_CODEC_ID_PIXLET)
-    .value("AV_CODEC_ID_SPEEDHQ", AV_CODEC_ID_SPEEDHQ)
-    .value("AV_CODEC_ID_FMVC", AV_CODEC_ID_FMVC)
-    .value("AV_CODEC_ID_SCPR", AV_CODEC_ID_SCPR)
-    .value("AV_CODEC_ID_CLEARVIDEO", AV_CODEC_ID_CLEARVIDEO)
-    .value("AV_CODEC_ID_XPM", AV_CODEC_ID_XPM)
-    .value("AV_CODEC_ID_AV1", AV_CODEC_ID_AV1)
-    .value("AV_CODEC_ID_BITPACKED", AV_CODEC_ID_BITPACKED)
-    .value("AV_CODEC_ID_MSCC", AV_CODEC_ID_MSCC)
-    .value("AV_CODEC_ID_SRGC", AV_CODEC_ID_SRGC)
-    .value("AV_CODEC_ID_SVG", AV_CODEC_ID_SVG)
-    .value("AV_CODEC_ID_GDV", AV_CODEC_ID_GDV)
-    .value("AV_CODEC_ID_FITS", AV_CODEC_ID_FITS)
-    .value("AV_CODEC_ID_IMM4", AV_CODEC_ID_IMM4)
-    .value("AV_CODEC_ID_PROSUMER", AV_CODEC_ID_PROSUMER)
-    .value("AV_CODEC_ID_MWSC", AV_CODEC_ID_MWSC)
-    .value("AV_CODEC_ID_WCMV", AV_CODEC_ID_WCMV)
-    .value("AV_CODEC_ID_RASC", AV_CODEC_ID_RASC)
-    .value("AV_CODEC_ID_HYMT", AV_CODEC_ID_HYMT)
-    .value("AV_CODEC_ID_ARBC", AV_CODEC_ID_ARBC)
-    .value("AV_CODEC_ID_AGM", AV_CODEC_ID_AGM)
-    .value("AV_CODEC_ID_LSCR", AV_CODEC_ID_LSCR)
-    .value("AV_CODEC_ID_VP4", AV_CODEC_ID_VP4)
-    .value("AV_CODEC_ID_FIRST_AUDIO", AV_CODEC_ID_FIRST_AUDIO)
-    .value("AV_CODEC_ID_PCM_S16LE", AV_CODEC_ID_PCM_S16LE)
-    .value("AV_CODEC_ID_PCM_S16BE", AV_CODEC_ID_PCM_S16BE)
-    .value("AV_CODEC_ID_PCM_U16LE", AV_CODEC_ID_PCM_U16LE)
-    .value("AV_CODEC_ID_PCM_U16BE", AV_CODEC_ID_PCM_U16BE)
-    .value("AV_CODEC_ID_PCM_S8", AV_CODEC_ID_PCM_S8)
-    .value("AV_CODEC_ID_PCM_U8", AV_CODEC_ID_PCM_U8)
-    .value("AV_CODEC_ID_PCM_MULAW", AV_CODEC_ID_PCM_MULAW)
-    .value("AV_CODEC_ID_PCM_ALAW", AV_CODEC_ID_PCM_ALAW)
-    .value("AV_CODEC_ID_PCM_S32LE", AV_CODEC_ID_PCM_S32LE)
-    .value("AV_CODEC_ID_PCM_S32BE", AV_CODEC_ID_PCM_S32BE)
-    .value("AV_CODEC_ID_PCM_U32LE", AV_CODEC_ID_PCM_U32LE)
-    .value("AV_CODEC_ID_PCM_U32BE", AV_CODEC_ID_PCM_U32BE)
-    .value("AV_CODEC_ID_PCM_S24LE", AV_CODEC_ID_PCM_S24LE)
-    .value("AV_CODEC_ID_PCM_S24BE", AV_CODEC_ID_PCM_S24BE)
-    .value("AV_CODEC_ID_PCM_U24LE", AV_CODEC_ID_PCM_U24LE)
-    .value("AV_CODEC_ID_PCM_U24BE", AV_CODEC_ID_PCM_U24BE)
-    .value("AV_CODEC_ID_PCM_S24DAUD", AV_CODEC_ID_PCM_S24DAUD)
-    .value("AV_CODEC_ID_PCM_ZORK", AV_CODEC_ID_PCM_ZORK)
-    .value("AV_CODEC_ID_PCM_S16LE_PLANAR", AV_CODEC_ID_PCM_S16LE_PLANAR)
-    .value("AV_CODEC_ID_PCM_DVD", AV_CODEC_ID_PCM_DVD)
-    .value("AV_CODEC_ID_PCM_F32BE", AV_CODEC_ID_PCM_F32BE)
-    .value("AV_CODEC_ID_PCM_F32LE", AV_CODEC_ID_PCM_F32LE)
-    .value("AV_CODEC_ID_PCM_F64BE", AV_CODEC_ID_PCM_F64BE)
-    .value("AV_CODEC_ID_PCM_F64LE", AV_CODEC_ID_PCM_F64LE)
-    .value("AV_CODEC_ID_PCM_BLURAY", AV_CODEC_ID_PCM_BLURAY)
-    .value("AV_CODEC_ID_PCM_LXF", AV_CODEC_ID_PCM_LXF)
-    .value("AV_CODEC_ID_S302M", AV_CODEC_ID_S302M)
-    .value("AV_CODEC_ID_PCM_S8_PLANAR", AV_CODEC_ID_PCM_S8_PLANAR)
-    .value("AV_CODEC_ID_PCM_S24LE_PLANAR", AV_CODEC_ID_PCM_S24LE_PLANAR)
-    .value("AV_CODEC_ID_PCM_S32LE_PLANAR", AV_CODEC_ID_PCM_S32LE_PLANAR)
-    .value("AV_CODEC_ID_PCM_S16BE_PLANAR", AV_CODEC_ID_PCM_S16BE_PLANAR)
-    .value("AV_CODEC_ID_PCM_S64LE", AV_CODEC_ID_PCM_S64LE)
-    .value("AV_CODEC_ID_PCM_S64BE", AV_CODEC_ID_PCM_S64BE)
-    .value("AV_CODEC_ID_PCM_F16LE", AV_CODEC_ID_PCM_F16LE)
-    .value("AV_CODEC_ID_PCM_F24LE", AV_CODEC_ID_PCM_F24LE)
-    .value("AV_CODEC_ID_PCM_VIDC", AV_CODEC_ID_PCM_VIDC)
-    .value("AV_CODEC_ID_ADPCM_IMA_QT", AV_CODEC_ID_ADPCM_IMA_QT)
-    .value("AV_CODEC_ID_ADPCM_IMA_WAV", AV_CODEC_ID_ADPCM_IMA_WAV)
-    .value("AV_CODEC_ID_ADPCM_IMA_DK3", AV_CODEC_ID_ADPCM_IMA_DK3)
-    .value("AV_CODEC_ID_ADPCM_IMA_DK4", AV_CODEC_ID_ADPCM_IMA_DK4)
-    .value("AV_CODEC_ID_ADPCM_IMA_WS", AV_CODEC_ID_ADPCM_IMA_WS)
-    .value("AV_CODEC_ID_ADPCM_IMA_SMJPEG", AV_CODEC_ID_ADPCM_IMA_SMJPEG)
-    .value("AV_CODEC_ID_ADPCM_MS", AV_CODEC_ID_ADPCM_MS)
-    .value("AV_CODEC_ID_ADPCM_4XM", AV_CODEC_ID_ADPCM_4XM)
-    .value("AV_CODEC_ID_ADPCM_XA", AV_CODEC_ID_ADPCM_XA)
-    .value("AV_CODEC_ID_ADPCM_ADX", AV_CODEC_ID_ADPCM_ADX)
-    .value("AV_CODEC_ID_ADPCM_EA", AV_CODEC_ID_ADPCM_EA)
-    .value("AV_CODEC_ID_ADPCM_G726", AV_CODEC_ID_ADPCM_G726)
-    .value("AV_CODEC_ID_ADPCM_CT", AV_CODEC_ID_ADPCM_CT)
-    .value("AV_CODEC_ID_ADPCM_SWF", AV_CODEC_ID_ADPCM_SWF)
-    .value("AV_CODEC_ID_ADPCM_YAMAHA", AV_CODEC_ID_ADPCM_YAMAHA)
-    .value("AV_CODEC_ID_ADPCM_SBPRO_4", AV_CODEC_ID_ADPCM_SBPRO_4)
-    .value("AV_CODEC_ID_ADPCM_SBPRO_3", AV_CODEC_ID_ADPCM_SBPRO_3)
-    .value("AV_CODEC_ID_ADPCM_SBPRO_2", AV_CODEC_ID_ADPCM_SBPRO_2)
-    .value("AV_CODEC_ID_ADPCM_THP", AV_CODEC_ID_ADPCM_THP)
-    .value("AV_CODEC_ID_ADPCM_IMA_AMV", AV_CODEC_ID_ADPCM_IMA_AMV)
-    .value("AV_CODEC_ID_ADPCM_EA_R1", AV_CODEC_ID_ADPCM_EA_R1)
-    .value("AV_CODEC_ID_ADPCM_EA_R3", AV_CODEC_ID_ADPCM_EA_R3)
-    .value("AV_CODEC_ID_ADPCM_EA_R2", AV_CODEC_ID_ADPCM_EA_R2)
-    .value("AV_CODEC_ID_ADPCM_IMA_EA_SEAD", AV_CODEC_ID_ADPCM_IMA_EA_SEAD)
-    .value("AV_CODEC_ID_ADPCM_IMA_EA_EACS", AV_CODEC_ID_ADPCM_IMA_EA_EACS)
-    .value("AV_CODEC_ID_ADPCM_EA_XAS", AV_CODEC_ID_ADPCM_EA_XAS)
-    .value("AV_CODEC_ID_ADPCM_EA_MAXIS_XA", AV_CODEC_ID_ADPCM_EA_MAXIS_XA)
-    .value("AV_CODEC_ID_ADPCM_IMA_ISS", AV_CODEC_ID_ADPCM_IMA_ISS)
-    .value("AV_CODEC_ID_ADPCM_G722", AV_CODEC_ID_ADPCM_G722)
-    .value("AV_CODEC_ID_ADPCM_IMA_APC", AV_CODEC_ID_ADPCM_IMA_APC)
-    .value("AV_CODEC_ID_ADPCM_VIMA", AV_CODEC_ID_ADPCM_VIMA)
-    .value("AV_CODEC_ID_ADPCM_AFC", AV_CODEC_ID_ADPCM_AFC)
-    .value("AV_CODEC_ID_ADPCM_IMA_OKI", AV_CODEC_ID_ADPCM_IMA_OKI)
-    .value("AV_CODEC_ID_ADPCM_DTK", AV_CODEC_ID_ADPCM_DTK)
-    .value("AV_CODEC_ID_ADPCM_IMA_RAD", AV_CODEC_ID_ADPCM_IMA_RAD)
-    .value("AV_CODEC_ID_ADPCM_G726LE", AV_CODEC_ID_ADPCM_G726LE)
-    .value("AV_CODEC_ID_ADPCM_THP_LE", AV_CODEC_ID_ADPCM_THP_LE)
-    .value("AV_CODEC_ID_ADPCM_PSX", AV_CODEC_ID_ADPCM_PSX)
-    .value("AV_CODEC_ID_ADPCM_AICA", AV_CODEC_ID_ADPCM_AICA)
-    .value("AV_CODEC_ID_ADPCM_IMA_DAT4", AV_CODEC_ID_ADPCM_IMA_DAT4)
-    .value("AV_CODEC_ID_ADPCM_MTAF", AV_CODEC_ID_ADPCM_MTAF)
-    .value("AV_CODEC_ID_ADPCM_AGM", AV_CODEC_ID_ADPCM_AGM)
-    .value("AV_CODEC_ID_AMR_NB", AV_CODEC_ID_AMR_NB)
-    .value("AV_CODEC_ID_AMR_WB", AV_CODEC_ID_AMR_WB)
-    .value("AV_CODEC_ID_RA_144", AV_CODEC_ID_RA_144)
-    .value("AV_CODEC_ID_RA_288", AV_CODEC_ID_RA_288)
-    .value("AV_CODEC_ID_ROQ_DPCM", AV_CODEC_ID_ROQ_DPCM)
-    .value("AV_CODEC_ID_INTERPLAY_DPCM", AV_CODEC_ID_INTERPLAY_DPCM)
-    .value("AV_CODEC_ID_XAN_DPCM", AV_CODEC_ID_XAN_DPCM)
-    .value("AV_CODEC_ID_SOL_DPCM", AV_CODEC_ID_SOL_DPCM)
-    .value("AV_CODEC_ID_SDX2_DPCM", AV_CODEC_ID_SDX2_DPCM)
-    .value("AV_CODEC_ID_GREMLIN_DPCM", AV_CODEC_ID_GREMLIN_DPCM)
-    .value("AV_CODEC_ID_MP2", AV_CODEC_ID_MP2)
-    .value("AV_CODEC_ID_MP3", AV_CODEC_ID_MP3)
-    .value("AV_CODEC_ID_AAC", AV_CODEC_ID_AAC)
-    .value("AV_CODEC_ID_AC3", AV_CODEC_ID_AC3)
-    .value("AV_CODEC_ID_DTS", AV_CODEC_ID_DTS)
-    .value("AV_CODEC_ID_VORBIS", AV_CODEC_ID_VORBIS)
-    .value("AV_CODEC_ID_DVAUDIO", AV_CODEC_ID_DVAUDIO)
-    .value("AV_CODEC_ID_WMAV1", AV_CODEC_ID_WMAV1)
-    .value("AV_CODEC_ID_WMAV2", AV_CODEC_ID_WMAV2)
-    .value("AV_CODEC_ID_MACE3", AV_CODEC_ID_MACE3)
-    .value("AV_CODEC_ID_MACE6", AV_CODEC_ID_MACE6)
-    .value("AV_CODEC_ID_VMDAUDIO", AV_CODEC_ID_VMDAUDIO)
-    .value("AV_CODEC_ID_FLAC", AV_CODEC_ID_FLAC)
-    .value("AV_CODEC_ID_MP3ADU", AV_CODEC_ID_MP3ADU)
-    .value("AV_CODEC_ID_MP3ON4", AV_CODEC_ID_MP3ON4)
-    .value("AV_CODEC_ID_SHORTEN", AV_CODEC_ID_SHORTEN)
-    .value("AV_CODEC_ID_ALAC", AV_CODEC_ID_ALAC)
-    .value("AV_CODEC_ID_WESTWOOD_SND1", AV_CODEC_ID_WESTWOOD_SND1)
-    .value("AV_CODEC_ID_GSM", AV_CODEC_ID_GSM)
-    .value("AV_CODEC_ID_QDM2", AV_CODEC_ID_QDM2)
-    .value("AV_CODEC_ID_COOK", AV_CODEC_ID_COOK)
-    .value("AV_CODEC_ID_TRUESPEECH", AV_CODEC_ID_TRUESPEECH)
-    .value("AV_CODEC_ID_TTA", AV_CODEC_ID_TTA)
-    .value("AV_CODEC_ID_SMACKAUDIO", AV_CODEC_ID_SMACKAUDIO)
-    .value("AV_CODEC_ID_QCELP", AV_CODEC_ID_QCELP)
-    .value("AV_CODEC_ID_WAVPACK", AV_CODEC_ID_WAVPACK)
-    .value("AV_CODEC_ID_DSICINAUDIO", AV_CODEC_ID_DSICINAUDIO)
-    .value("AV_CODEC_ID_IMC", AV_CODEC_ID_IMC)
-    .value("AV_CODEC_ID_MUSEPACK7", AV_CODEC_ID_MUSEPACK7)
-    .value("AV_CODEC_ID_MLP", AV_CODEC_ID_MLP)
-    .value("AV_CODEC_ID_GSM_MS", AV_CODEC_ID_GSM_MS)
-    .value("AV_CODEC_ID_ATRAC3", AV_CODEC_ID_ATRAC3)
-    .value("AV_CODEC_ID_APE", AV_CODEC_ID_APE)
-    .value("AV_CODEC_ID_NELLYMOSER", AV_CODEC_ID_NELLYMOSER)
-    .value("AV_CODEC_ID_MUSEPACK8", AV_CODEC_ID_MUSEPACK8)
-    .value("AV_CODEC_ID_SPEEX", AV_CODEC_ID_SPEEX)
-    .value("AV_CODEC_ID_WMAVOICE", AV_CODEC_ID_WMAVOICE)
-    .value("AV_CODEC_ID_WMAPRO", AV_CODEC_ID_WMAPRO)
-    .value("AV_CODEC_ID_WMALOSSLESS", AV_CODEC_ID_WMALOSSLESS)
-    .value("AV_CODEC_ID_ATRAC3P", AV_CODEC_ID_ATRAC3P)
-    .value("AV_CODEC_ID_EAC3", AV_CODEC_ID_EAC3)
-    .value("AV_CODEC_ID_SIPR", AV_CODEC_ID_SIPR)
-    .value("AV_CODEC_ID_MP1", AV_CODEC_ID_MP1)
-    .value("AV_CODEC_ID_TWINVQ", AV_CODEC_ID_TWINVQ)
-    .value("AV_CODEC_ID_TRUEHD", AV_CODEC_ID_TRUEHD)
-    .value("AV_CODEC_ID_MP4ALS", AV_CODEC_ID_MP4ALS)
-    .value("AV_CODEC_ID_ATRAC1", AV_CODEC_ID_ATRAC1)
-    .value("AV_CODEC_ID_BINKAUDIO_RDFT", AV_CODEC_ID_BINKAUDIO_RDFT)
-    .value("AV_CODEC_ID_BINKAUDIO_DCT", AV_CODEC_ID_BINKAUDIO_DCT)
-    .value("AV_CODEC_ID_AAC_LATM", AV_CODEC_ID_AAC_LATM)
-    .value("AV_CODEC_ID_QDMC", AV_CODEC_ID_QDMC)
-    .value("AV_CODEC_ID_CELT", AV_CODEC_ID_CELT)
-    .value("AV_CODEC_ID_G723_1", AV_CODEC_ID_G723_1)
-    .value("AV_CODEC_ID_G729", AV_CODEC_ID_G729)
-    .value("AV_CODEC_ID_8SVX_EXP", AV_CODEC_ID_8SVX_EXP)
-    .value("AV_CODEC_ID_8SVX_FIB", AV_CODEC_ID_8SVX_FIB)
-    .value("AV_CODEC_ID_BMV_AUDIO", AV_CODEC_ID_BMV_AUDIO)
-    .value("AV_CODEC_ID_RALF", AV_CODEC_ID_RALF)
-    .value("AV_CODEC_ID_IAC", AV_CODEC_ID_IAC)
-    .value("AV_CODEC_ID_ILBC", AV_CODEC_ID_ILBC)
-    .value("AV_CODEC_ID_OPUS", AV_CODEC_ID_OPUS)
-    .value("AV_CODEC_ID_COMFORT_NOISE", AV_CODEC_ID_COMFORT_NOISE)
-    .value("AV_CODEC_ID_TAK", AV_CODEC_ID_TAK)
-    .value("AV_CODEC_ID_METASOUND", AV_CODEC_ID_METASOUND)
-    .value("AV_CODEC_ID_PAF_AUDIO", AV_CODEC_ID_PAF_AUDIO)
-    .value("AV_CODEC_ID_ON2AVC", AV_CODEC_ID_ON2AVC)
-    .value("AV_CODEC_ID_DSS_SP", AV_CODEC_ID_DSS_SP)
-    .value("AV_CODEC_ID_CODEC2", AV_CODEC_ID_CODEC2)
-    .value("AV_CODEC_ID_FFWAVESYNTH", AV_CODEC_ID_FFWAVESYNTH)
-    .value("AV_CODEC_ID_SONIC", AV_CODEC_ID_SONIC)
-    .value("AV_CODEC_ID_SONIC_LS", AV_CODEC_ID_SONIC_LS)
-    .value("AV_CODEC_ID_EVRC", AV_CODEC_ID_EVRC)
-    .value("AV_CODEC_ID_SMV", AV_CODEC_ID_SMV)
-    .value("AV_CODEC_ID_DSD_LSBF", AV_CODEC_ID_DSD_LSBF)
-    .value("AV_CODEC_ID_DSD_MSBF", AV_CODEC_ID_DSD_MSBF)
-    .value("AV_CODEC_ID_DSD_LSBF_PLANAR", AV_CODEC_ID_DSD_LSBF_PLANAR)
-    .value("AV_CODEC_ID_DSD_MSBF_PLANAR", AV_CODEC_ID_DSD_MSBF_PLANAR)
-    .value("AV_CODEC_ID_4GV", AV_CODEC_ID_4GV)
-    .value("AV_CODEC_ID_INTERPLAY_ACM", AV_CODEC_ID_INTERPLAY_ACM)
-    .value("AV_CODEC_ID_XMA1", AV_CODEC_ID_XMA1)
-    .value("AV_CODEC_ID_XMA2", AV_CODEC_ID_XMA2)
-    .value("AV_CODEC_ID_DST", AV_CODEC_ID_DST)
-    .value("AV_CODEC_ID_ATRAC3AL", AV_CODEC_ID_ATRAC3AL)
-    .value("AV_CODEC_ID_ATRAC3PAL", AV_CODEC_ID_ATRAC3PAL)
-    .value("AV_CODEC_ID_DOLBY_E", AV_CODEC_ID_DOLBY_E)
-    .value("AV_CODEC_ID_APTX", AV_CODEC_ID_APTX)
-    .value("AV_CODEC_ID_APTX_HD", AV_CODEC_ID_APTX_HD)
-    .value("AV_CODEC_ID_SBC", AV_CODEC_ID_SBC)
-    .value("AV_CODEC_ID_ATRAC9", AV_CODEC_ID_ATRAC9)
-    .value("AV_CODEC_ID_HCOM", AV_CODEC_ID_HCOM);
-#pragma endregion AVCodecID enums
+void close_input_context(AVFormatContext** fmt_ctx, AVIOContext** io) {
+  avformat_close_input(fmt_ctx);
+
+  // custom IO is left alone by avformat_close_input
+  if (*io) {
+    av_freep(&(*io)->buffer);
+    avio_context_free(io);
+  }
+}
+
+// Presentation timestamps of every keyframe in a stream. They're read off the
+// packets rather than the demuxer's index, whose entries are in decode order.
+std::vector<int64_t> collect_keyframes(AVFormatContext* fmt_ctx, int stream_index) {
+  std::vector<int64_t> keyframes;
+  AVPacket* pkt = av_packet_alloc();
+
+  if (!pkt)
+    return keyframes;
+
+  for (unsigned i = 0; i < fmt_ctx->nb_streams; i++) {
+    if ((int) i != stream_index)
+      fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+  }
+
+  while (av_read_frame(fmt_ctx, pkt) >= 0) {
+    if (pkt->stream_index == stream_index && (pkt->flags & AV_PKT_FLAG_KEY) &&
+        pkt->pts != AV_NOPTS_VALUE)
+      keyframes.push_back(pkt->pts);
+
+    av_packet_unref(pkt);
+  }
+
+  av_packet_free(&pkt);
+
+  return keyframes;
+}
+
+// Presentation timestamps of the keyframes in the demuxer's index, empty when
+// it has none. Containers like mov index decode times, so the entries are
+// moved by the delay between the two on the first packet of the stream, which
+// is the only one read.
+std::vector<int64_t> get_indexed_keyframes(AVFormatContext* fmt_ctx, int stream_index) {
+  AVStream* stream = fmt_ctx->streams[stream_index];
+  std::vector<int64_t> keyframes;
+
+  for (int i = 0; i < stream->nb_index_entries; i++) {
+    if (stream->index_entries[i].flags & AVINDEX_KEYFRAME)
+      keyframes.push_back(stream->index_entries[i].timestamp);
+  }
+
+  AVPacket* pkt = keyframes.empty() ? NULL : av_packet_alloc();
+
+  if (!pkt)
+    return keyframes;
+
+  for (unsigned i = 0; i < fmt_ctx->nb_streams; i++) {
+    if ((int) i != stream_index)
+      fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+  }
+
+  int64_t delay = 0;
+
+  while (av_read_frame(fmt_ctx, pkt) >= 0) {
+    bool found = pkt->stream_index == stream_index;
+
+    if (found && pkt->pts != AV_NOPTS_VALUE && pkt->dts != AV_NOPTS_VALUE)
+      delay = pkt->pts - pkt->dts;
+
+    av_packet_unref(pkt);
+
+    if (found)
+      break;
+  }
+
+  av_packet_free(&pkt);
+
+  for (int64_t& keyframe : keyframes)
+    keyframe += delay;
+
+  return keyframes;
+}
+
+// Splits the input into at most `count` ranges of roughly equal length that
+// start on a video keyframe, so each one can be transcoded on its own. Returns
+// the cut points in seconds, empty when the input can't be split.
+val plan_segments(InputSource& input, int count) {
+  val cuts = val::array();
+  AVFormatContext* fmt_ctx = NULL;
+  AVIOContext* io = NULL;
+
+  if (count > 1 && open_input_context(input, &fmt_ctx, &io) >= 0) {
+    int index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+
+    if (index >= 0) {
+      AVStream* stream = fmt_ctx->streams[index];
+      std::vector<int64_t> keyframes = get_indexed_keyframes(fmt_ctx, index);
+
+      // without an index the whole input has to be demuxed
+      if (keyframes.empty())
+        keyframes = collect_keyframes(fmt_ctx, index);
+
+      std::sort(keyframes.begin(), keyframes.end());
+
+      int64_t duration = stream->duration != AV_NOPTS_VALUE
+        ? stream->duration
+        : av_rescale_q(fmt_ctx->duration, AV_TIME_BASE_Q, stream->time_base);
+
+      if (keyframes.size() > 1 && duration > 0) {
+        int64_t first = keyframes.front();
+        int64_t last = first;
+
+        for (int i = 1; i < count; i++) {
+          int64_t target = first + av_rescale(duration, i, count);
+          auto it = std::lower_bound(keyframes.begin(), keyframes.end(), target);
+
+          if (it == keyframes.end())
+            break;
+          if (*it <= last)
+            continue;
+
+          last = *it;
+          cuts.call<void>("push", last * av_q2d(stream->time_base));
+        }
+      }
+    }
+  }
+
+  close_input_context(&fmt_ctx, &io);
+
+  return cuts;
+}
+
+const int DEFAULT_PROBE_SIZE = 1024 * 1024;
+
+val get_stream_info(AVFormatContext* fmt_ctx, int index) {
+  AVStream* stream = fmt_ctx->streams[index];
+  AVCodecParameters* par = stream->codecpar;
+  const AVCodecDescriptor* descriptor = avcodec_descriptor_get(par->codec_id);
+  const char* type = av_get_media_type_string(par->codec_type);
+  const char* profile = avcodec_profile_name(par->codec_id, par->profile);
+  AVDictionaryEntry* language = av_dict_get(stream->metadata, "language", NULL, 0);
+
+  val info = val::object();
+
+  info.set("index", index);
+  info.set("type", string(type ? type : "unknown"));
+  info.set("codec", string(avcodec_get_name(par->codec_id)));
+  info.set("codecLongName", string(descriptor && descriptor->long_name ? descriptor->long_name : ""));
+  info.set("profile", string(profile ? profile : ""));
+  info.set("bitRate", (double) par->bit_rate);
+  info.set("duration", stream->duration != AV_NOPTS_VALUE ? stream->duration * av_q2d(stream->time_base) : 0);
+  info.set("language", string(language ? language->value : ""));
+
+  if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+    const char* pix_fmt = av_get_pix_fmt_name((AVPixelFormat) par->format);
+
+    info.set("width", par->width);
+    info.set("height", par->height);
+    info.set("pixelFormat", string(pix_fmt ? pix_fmt : ""));
+    info.set("frameRate", av_q2d(av_guess_frame_rate(fmt_ctx, stream, NULL)));
+    info.set("rotation", get_rotation(stream));
+  } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+    const char* sample_fmt = av_get_sample_fmt_name((AVSampleFormat) par->format);
+    char channel_layout[64];
+
+    av_get_channel_layout_string(channel_layout, sizeof(channel_layout), par->channels, par->channel_layout);
+
+    info.set("sampleRate", par->sample_rate);
+    info.set("channels", par->channels);
+    info.set("channelLayout", string(channel_layout));
+    info.set("sampleFormat", string(sample_fmt ? sample_fmt : ""));
+  }
+
+  return info;
+}
+
+// Fills `info` with what the container headers say about the input, plus what
+// avformat_find_stream_info decodes out of its first `probeSize` bytes. The
+// keyframes of the main video stream come from the demuxer's index by default,
+// which is cheap but may hold decode times, `keyframes: "scan"` reads every
+// packet for their exact presentation times and "none" skips them.
+int probe_input(InputSource& input, val opts, val info) {
+  AVFormatContext* fmt_ctx = NULL;
+  AVIOContext* io = NULL;
+  AVDictionary* format_opts = NULL;
+
+  av_dict_set_int(&format_opts, "probesize",
+    (int64_t) get_number_option(opts, "probeSize", DEFAULT_PROBE_SIZE), 0);
+
+  int ret = open_input_context(input, &fmt_ctx, &io, &format_opts);
+  av_dict_free(&format_opts);
+
+  if (ret < 0) {
+    close_input_context(&fmt_ctx, &io);
+    return ret;
+  }
+
+  const char* long_name = fmt_ctx->iformat->long_name;
+
+  info.set("format", string(fmt_ctx->iformat->name));
+  info.set("formatLongName", string(long_name ? long_name : ""));
+  info.set("duration", fmt_ctx->duration != AV_NOPTS_VALUE ? fmt_ctx->duration / (double) AV_TIME_BASE : 0);
+  info.set("startTime", fmt_ctx->start_time != AV_NOPTS_VALUE ? fmt_ctx->start_time / (double) AV_TIME_BASE : 0);
+  info.set("bitRate", (double) fmt_ctx->bit_rate);
+
+  val streams = val::array();
+
+  for (unsigned i = 0; i < fmt_ctx->nb_streams; i++)
+    streams.call<void>("push", get_stream_info(fmt_ctx, i));
+
+  info.set("streams", streams);
+
+  // the streams a conversion would pick
+  int video_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+  int audio_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+
+  info.set("videoStream", video_index >= 0 ? val(video_index) : val::null());
+  info.set("audioStream", audio_index >= 0 ? val(audio_index) : val::null());
+
+  val keyframes = val::array();
+  string keyframe_mode = get_string_option(opts, "keyframes");
+
+  if (video_index >= 0 && keyframe_mode != "none") {
+    AVStream* stream = fmt_ctx->streams[video_index];
+    double time_base = av_q2d(stream->time_base);
+
+    if (keyframe_mode == "scan") {
+      for (int64_t pts : collect_keyframes(fmt_ctx, video_index))
+        keyframes.call<void>("push", pts * time_base);
+    } else {
+      for (int64_t pts : get_indexed_keyframes(fmt_ctx, video_index))
+        keyframes.call<void>("push", pts * time_base);
+    }
+  }
+
+  info.set("keyframes", keyframes);
+
+  close_input_context(&fmt_ctx, &io);
+
+  return 0;
+}
+
+// Thumbnails are at most this many pixels on each side unless asked otherwise
+const int DEFAULT_THUMBNAIL_SIZE = 320;
+
+struct ThumbnailOptions {
+  std::vector<double> times;
+  int count = 1;
+  bool keyframes_only = false;
+  int max_width = DEFAULT_THUMBNAIL_SIZE;
+  int max_height = DEFAULT_THUMBNAIL_SIZE;
+  string format = "rgba";
+};
+
+ThumbnailOptions parse_thumbnail_options(const val& opts) {
+  ThumbnailOptions options;
+
+  val times = opts["times"];
+
+  if (!times.isUndefined() && !times.isNull()) {
+    int length = times["length"].as<int>();
+
+    for (int i = 0; i < length; i++)
+      options.times.push_back(times[i].as<double>());
+  }
+
+  options.count = FFMAX((int) get_number_option(opts, "count", 1), 1);
+  options.keyframes_only = opts["keyframesOnly"].isTrue();
+  options.max_width = (int) get_number_option(opts, "width", DEFAULT_THUMBNAIL_SIZE);
+  options.max_height = (int) get_number_option(opts, "height", DEFAULT_THUMBNAIL_SIZE);
+
+  string format = get_string_option(opts, "format");
+
+  if (!format.empty())
+    options.format = format;
+
+  return options;
+}
+
+// Timestamps, in seconds, of `count` frames spread evenly over the input, each
+// one in the middle of its share so the black first frame is skipped. Without
+// a known duration there is nothing to spread them over, so only the frame at
+// the start is taken
+std::vector<double> spread_thumbnail_times(const AVFormatContext* fmt_ctx, int count) {
+  double start = fmt_ctx->start_time != AV_NOPTS_VALUE ? fmt_ctx->start_time / (double) AV_TIME_BASE : 0;
+  double duration = fmt_ctx->duration != AV_NOPTS_VALUE ? fmt_ctx->duration / (double) AV_TIME_BASE : 0;
+  std::vector<double> times;
+
+  if (duration <= 0) {
+    if (count > 1)
+      av_log(NULL, AV_LOG_WARNING, "Input duration is unknown, taking one thumbnail instead of %d\n", count);
+
+    times.push_back(start);
+    return times;
+  }
+
+  for (int i = 0; i < count; i++)
+    times.push_back(start + duration * (i + 0.5) / count);
+
+  return times;
+}
+
+// Fits the frame's display size in `max_width`x`max_height` without changing
+// its aspect ratio, a bound of 0 or less leaves that side alone
+void fit_thumbnail_size(const AVFrame* frame, int max_width, int max_height, int* width, int* height) {
+  AVRational sar = frame->sample_aspect_ratio;
+  double display_width = frame->width * (sar.num > 0 && sar.den > 0 ? av_q2d(sar) : 1);
+  double scale = 1;
+
+  if (max_width > 0)
+    scale = FFMIN(scale, max_width / display_width);
+  if (max_height > 0)
+    scale = FFMIN(scale, max_height / (double) frame->height);
+
+  *width = FFMAX((int) lrint(display_width * scale), 1);
+  *height = FFMAX((int) lrint(frame->height * scale), 1);
+}
+
+int open_thumbnail_decoder(AVFormatContext* fmt_ctx, int index, bool keyframes_only, AVCodecContext** dec_ctx) {
+  AVStream* stream = fmt_ctx->streams[index];
+  const AVCodec* decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+
+  if (!decoder) {
+    av_log(NULL, AV_LOG_ERROR, "Failed to find decoder for stream #%d\n", index);
+    return AVERROR_DECODER_NOT_FOUND;
+  }
+
+  if (!(*dec_ctx = avcodec_alloc_context3(decoder)))
+    return AVERROR(ENOMEM);
+
+  int ret;
+
+  if ((ret = avcodec_parameters_to_context(*dec_ctx, stream->codecpar)) < 0)
+    return ret;
+
+  (*dec_ctx)->pkt_timebase = stream->time_base;
+
+  // only a handful of frames get decoded, frame threads would just add delay
+  (*dec_ctx)->thread_count = get_codec_thread_count();
+  (*dec_ctx)->thread_type = FF_THREAD_SLICE;
+
+  if (keyframes_only)
+    (*dec_ctx)->skip_frame = AVDISCARD_NONKEY;
+
+  return avcodec_open2(*dec_ctx, decoder, NULL);
+}
+
+// Decodes the first frame at or after `time`, starting from the keyframe before
+// it. With `keyframes_only` every other frame is skipped by the decoder, so the
+// keyframe itself is what comes out. Past the end of the stream the last frame
+// is used instead.
+int decode_thumbnail_frame(AVFormatContext* fmt_ctx, AVCodecContext* dec_ctx, int index, double time, bool keyframes_only, AVPacket* pkt, AVFrame* frame) {
+  AVStream* stream = fmt_ctx->streams[index];
+  int64_t target = llrint(time / av_q2d(stream->time_base));
+
+  if (avformat_seek_file(fmt_ctx, index, INT64_MIN, target, target, 0) < 0)
+    av_log(NULL, AV_LOG_WARNING, "Cannot seek to %f, decoding on from here\n", time);
+
+  avcodec_flush_buffers(dec_ctx);
+
+  // the previous candidate is kept in `frame` until a later one replaces it
+  AVFrame* decoded = av_frame_alloc();
+
+  if (!decoded)
+    return AVERROR(ENOMEM);
+
+  bool draining = false;
+  bool found = false;
+  int ret = 0;
+
+  while (!found) {
+    if (!draining) {
+      ret = av_read_frame(fmt_ctx, pkt);
+
+      if (ret == AVERROR_EOF) {
+        draining = true;
+        ret = avcodec_send_packet(dec_ctx, NULL);
+      } else if (ret >= 0) {
+        if (pkt->stream_index == index)
+          ret = avcodec_send_packet(dec_ctx, pkt);
+
+        av_packet_unref(pkt);
+
+        if (ret == AVERROR_INVALIDDATA)
+          ret = 0;
+      }
+
+      if (ret < 0)
+        break;
+    }
+
+    while ((ret = avcodec_receive_frame(dec_ctx, decoded)) >= 0) {
+      av_frame_unref(frame);
+      av_frame_move_ref(frame, decoded);
+
+      int64_t pts = frame->best_effort_timestamp;
+
+      if (keyframes_only || pts == AV_NOPTS_VALUE || pts >= target) {
+        found = true;
+        break;
+      }
+    }
+
+    if (ret == AVERROR_EOF || (draining && ret == AVERROR(EAGAIN)))
+      break;
+    if (ret < 0 && ret != AVERROR(EAGAIN))
+      break;
+  }
+
+  av_frame_free(&decoded);
+
+  if (!frame->data[0])
+    return ret < 0 ? ret : AVERROR_EOF;
+
+  return 0;
+}
+
+// Encodes a single scaled frame as a standalone PNG or JPEG image
+int encode_thumbnail(AVFrame* image, AVCodecID codec_id, AVPacket* pkt) {
+  const AVCodec* encoder = avcodec_find_encoder(codec_id);
+
+  if (!encoder) {
+    av_log(NULL, AV_LOG_ERROR, "Necessary encoder not found\n");
+    return AVERROR_ENCODER_NOT_FOUND;
+  }
+
+  AVCodecContext* enc_ctx = avcodec_alloc_context3(encoder);
+
+  if (!enc_ctx)
+    return AVERROR(ENOMEM);
+
+  enc_ctx->width = image->width;
+  enc_ctx->height = image->height;
+  enc_ctx->pix_fmt = (AVPixelFormat) image->format;
+  enc_ctx->time_base = { 1, 25 };
+
+  int ret;
+
+  if ((ret = avcodec_open2(enc_ctx, encoder, NULL)) >= 0 &&
+      (ret = avcodec_send_frame(enc_ctx, image)) >= 0 &&
+      (ret = avcodec_send_frame(enc_ctx, NULL)) >= 0)
+    ret = avcodec_receive_packet(enc_ctx, pkt);
+
+  avcodec_free_context(&enc_ctx);
+
+  return ret;
+}
+
+// Scales `frame` into a thumbnail and appends `{ time, width, height, data }`
+// to `thumbnails`, `data` being a copy outside of the wasm heap
+int append_thumbnail(AVFrame* frame, double time, const ThumbnailOptions& options, SwsContext** sws_ctx, AVPacket* pkt, val& thumbnails) {
+  AVPixelFormat pix_fmt = options.format == "jpeg" ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_RGBA;
+  AVFrame* image = av_frame_alloc();
+
+  if (!image)
+    return AVERROR(ENOMEM);
+
+  fit_thumbnail_size(frame, options.max_width, options.max_height, &image->width, &image->height);
+  image->format = pix_fmt;
+
+  *sws_ctx = sws_getCachedContext(*sws_ctx,
+    frame->width, frame->height, (AVPixelFormat) frame->format,
+    image->width, image->height, pix_fmt,
+    SWS_BILINEAR, NULL, NULL, NULL);
+
+  int ret;
+
+  // no row padding, so RGBA data can be handed out as is
+  if (!*sws_ctx) {
+    ret = AVERROR(EINVAL);
+  } else if ((ret = av_frame_get_buffer(image, 1)) >= 0) {
+    sws_scale(*sws_ctx, frame->data, frame->linesize, 0, frame->height, image->data, image->linesize);
+
+    val data = val::undefined();
+
+    if (options.format == "rgba") {
+      data = val(typed_memory_view(image->linesize[0] * image->height, image->data[0])).call<val>("slice");
+    } else if ((ret = encode_thumbnail(image, options.format == "png" ? AV_CODEC_ID_PNG : AV_CODEC_ID_MJPEG, pkt)) >= 0) {
+      data = val(typed_memory_view(pkt->size, pkt->data)).call<val>("slice");
+      av_packet_unref(pkt);
+    }
+
+    if (ret >= 0) {
+      val thumbnail = val::object();
+
+      thumbnail.set("time", time);
+      thumbnail.set("width", image->width);
+      thumbnail.set("height", image->height);
+      thumbnail.set("data", data);
+
+      thumbnails.call<void>("push", thumbnail);
+    }
+  }
+
+  av_frame_free(&image);
+
+  return ret;
+}
+
+// Pushes a thumbnail of the main video stream to `thumbnails` for each of
+// `opts.times`, or for `opts.count` times spread over the input. Only the
+// frames between each seek point and its time are decoded, so the cost doesn't
+// grow with the length of the input.
+int extract_thumbnails(InputSource& input, val opts, val thumbnails) {
+  ThumbnailOptions options = parse_thumbnail_options(opts);
+
+  if (options.format != "rgba" && options.format != "png" && options.format != "jpeg") {
+    av_log(NULL, AV_LOG_ERROR, "Unknown thumbnail format %s\n", options.format.c_str());
+    return AVERROR(EINVAL);
+  }
+
+  AVFormatContext* fmt_ctx = NULL;
+  AVIOContext* io = NULL;
+  AVCodecContext* dec_ctx = NULL;
+  SwsContext* sws_ctx = NULL;
+  AVPacket* pkt = av_packet_alloc();
+  AVFrame* frame = av_frame_alloc();
+  int index = -1;
+  int ret;
+
+  if (!pkt || !frame) {
+    ret = AVERROR(ENOMEM);
+  } else if ((ret = open_input_context(input, &fmt_ctx, &io)) >= 0 &&
+             (ret = index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0)) >= 0 &&
+             (ret = open_thumbnail_decoder(fmt_ctx, index, options.keyframes_only, &dec_ctx)) >= 0) {
+    for (unsigned i = 0; i < fmt_ctx->nb_streams; i++) {
+      if ((int) i != index)
+        fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    std::vector<double> times = options.times.empty()
+      ? spread_thumbnail_times(fmt_ctx, options.count)
+      : options.times;
+
+    for (double time : times) {
+      if ((ret = decode_thumbnail_frame(fmt_ctx, dec_ctx, index, time, options.keyframes_only, pkt, frame)) < 0)
+        break;
+
+      double frame_time = frame->best_effort_timestamp != AV_NOPTS_VALUE
+        ? frame->best_effort_timestamp * av_q2d(fmt_ctx->streams[index]->time_base)
+        : time;
+
+      ret = append_thumbnail(frame, frame_time, options, &sws_ctx, pkt, thumbnails);
+      av_frame_unref(frame);
+
+      if (ret < 0)
+        break;
+    }
+  }
+
+  sws_freeContext(sws_ctx);
+  avcodec_free_context(&dec_ctx);
+  av_frame_free(&frame);
+  av_packet_free(&pkt);
+  close_input_context(&fmt_ctx, &io);
+
+  return ret < 0 ? ret : 0;
+}
+
+// One encoded rendition of a decoded stream, fed by its own branch of the
+// stream's filter graph
+struct EncoderContext {
+  int output = -1;
+  int out_index = -1;
+  AVCodecContext* enc_ctx = NULL;
+  AVFilterContext* buffersink_ctx = NULL;
+  int64_t last_pts = AV_NOPTS_VALUE;
+};
+
+// An output the packets of a stream are copied to as they are
+struct CopyTarget {
+  int output;
+  int out_index;
+};
+
+struct StreamContext {
+  int in_index = -1;
+  AVCodecContext* dec_ctx = NULL;
+  AVFilterGraph* filter_graph = NULL;
+  AVFilterContext* buffersrc_ctx = NULL;
+  std::vector<EncoderContext> encoders;
+  std::vector<CopyTarget> copies;
+  // frames outside of [start_pts, end_pts) are decoded but not encoded
+  int64_t start_pts = AV_NOPTS_VALUE;
+  int64_t end_pts = AV_NOPTS_VALUE;
+  bool finished = false;
+
+  bool is_mapped() const {
+    return !encoders.empty() || !copies.empty();
+  }
+};
+
+struct OutputContext {
+  AVFormatContext* fmt_ctx = NULL;
+  AVIOContext* io = NULL;
+  OutputSink* sink = NULL;
+  ConvertOptions options;
+  // keys of `extraOptions` taken by one of its encoders or its muxer
+  std::set<string> used_options;
+  // 'v' and/or 'a' for the types of streams it encodes, not copies
+  std::set<char> encoded_types;
+};
+
+enum Stage {
+  STAGE_DEMUX,
+  STAGE_DECODE,
+  STAGE_FILTER,
+  STAGE_ENCODE,
+  STAGE_MUX,
+  STAGE_COUNT
+};
+
+// Counters of the last job, to tell which stage of the pipeline a slow job
+// spends its time in.
+struct JobStats {
+  // milliseconds of wall time, the filter stage is where frames get scaled
+  // and converted to the encoder's formats
+  double stage_time[STAGE_COUNT] = {};
+  int64_t packets_read = 0;
+  int64_t packets_written = 0;
+  int64_t frames_decoded = 0;
+  int64_t frames_encoded = 0;
+  // video frames that made it to the output, either encoded or copied
+  int64_t video_frames = 0;
+  int64_t bytes_read = 0;
+  // most of the heap the job held at once, measured from what was allocated
+  // when it began so the frames pooled by earlier jobs aren't counted
+  double peak_heap = 0;
+  double heap_baseline = 0;
+
+  // mallinfo walks the whole heap, so this isn't meant for every packet
+  double get_heap_used() const {
+    return (double) (unsigned) mallinfo().uordblks - heap_baseline;
+  }
+
+  void update_peak_heap() {
+    peak_heap = FFMAX(peak_heap, get_heap_used());
+  }
+};
+
+// Adds the wall time spent in its scope to a stage of the job.
+class StageTimer {
+ public:
+  StageTimer(JobStats& stats, Stage stage)
+    : total(stats.stage_time[stage]), start(emscripten_get_now()) {}
+
+  ~StageTimer() {
+    total += emscripten_get_now() - start;
+  }
+
+ private:
+  double& total;
+  double start;
+};
+
+// Native demux -> decode -> filter -> encode -> mux pipeline. The packet and
+// frame buffers live as long as the instance, so a single transcoder can be
+// reused across jobs without paying for ffmpeg's CLI startup on each one. A
+// job may have several outputs, the input being decoded once for all of them.
+class Transcoder {
+ public:
+  Transcoder()
+    : packet(av_packet_alloc()),
+      enc_packet(av_packet_alloc()),
+      copy_packet_ref(av_packet_alloc()),
+      frame(av_frame_alloc()),
+      filt_frame(av_frame_alloc()) {}
+
+  Transcoder(const Transcoder&) = delete;
+  Transcoder& operator=(const Transcoder&) = delete;
+
+  ~Transcoder() {
+    reset();
+    av_packet_free(&packet);
+    av_packet_free(&enc_packet);
+    av_packet_free(&copy_packet_ref);
+    av_frame_free(&frame);
+    av_frame_free(&filt_frame);
+  }
+
+  int run(InputSource& input, OutputSink& output, val opts);
+  int run_many(InputSource& input, val sinks, val output_options);
+  int concat(const string& list_path, OutputSink& output, val opts);
+  bool copies_video(InputSource& input, val opts);
+  void reset();
+
+  // Stops the running job before its next packet, the job then returns
+  // AVERROR_EXIT. Meant to be called from the JS callbacks of the job.
+  void cancel() {
+    cancelled = true;
+  }
+
+  val get_stats() const;
+
+ private:
+  int run_outputs(InputSource& input, const std::vector<OutputSink*>& sinks, const std::vector<ConvertOptions>& options);
+  void begin_job(const std::vector<OutputSink*>& sinks, const std::vector<ConvertOptions>& options);
+  void report_progress(bool force);
+  int open_input(InputSource& input);
+  int open_decoder(StreamContext& sc);
+  int seek_input(const ConvertOptions& options);
+  int check_memory_budget();
+  int open_outputs();
+  int map_stream(StreamContext& sc, int output);
+  int open_output_io(OutputContext& output);
+  int check_unused_options(const OutputContext& output);
+  int add_encoder(StreamContext& sc, int output, const string& encoder_name);
+  int open_encoder(StreamContext& sc, EncoderContext& ec);
+  int open_copy_stream(StreamContext& sc, int output);
+  bool can_copy_stream(const StreamContext& sc, int output, const string& encoder_name) const;
+  int init_filters(StreamContext& sc);
+  string get_branch_filter(const StreamContext& sc, const EncoderContext& ec) const;
+  bool is_mapped_type(const OutputContext& output, AVMediaType type) const;
+  bool is_before_start(StreamContext& sc, const AVPacket* pkt) const;
+  bool is_past_end(StreamContext& sc, const AVPacket* pkt) const;
+  int transcode();
+  int read_packet();
+  int decode_packet(StreamContext& sc, const AVPacket* pkt);
+  int copy_packet(StreamContext& sc, const AVPacket* pkt);
+  int write_packet(OutputContext& output, AVPacket* pkt);
+  int filter_encode_write_frame(StreamContext& sc, AVFrame* input);
+  int encode_write_frame(StreamContext& sc, EncoderContext& ec, AVFrame* input);
+
+  AVFormatContext* ifmt_ctx = NULL;
+  AVIOContext* input_io = NULL;
+  std::vector<StreamContext> streams;
+  std::vector<OutputContext> outputs;
+
+  val on_progress = val::undefined();
+  double progress_interval = 0;
+  double started_at = 0;
+  double reported_at = 0;
+  JobStats stats;
+  double position = 0;
+  bool cancelled = false;
+  double memory_limit = 0;
+  FramePool frame_pool;
+  // threads each video codec of the job gets, and what's left of the pool
+  int codec_threads = 1;
+  int threads_left = THREAD_POOL_SIZE;
+
+  AVPacket* packet;
+  AVPacket* enc_packet;
+  AVPacket* copy_packet_ref;
+  AVFrame* frame;
+  AVFrame* filt_frame;
+};
+
+int Transcoder::run(InputSource& input, OutputSink& output, val opts) {
+  return run_outputs(input, { &output }, { parse_convert_options(opts) });
+}
+
+// Converts the input to every one of `output_options`, each written to the
+// sink at the same index. The range, progress and memory options of the job
+// are read from the first output.
+int Transcoder::run_many(InputSource& input, val sinks, val output_options) {
+  std::vector<OutputSink*> output_sinks;
+  std::vector<ConvertOptions> options;
+  unsigned length = output_options["length"].as<unsigned>();
+
+  for (unsigned i = 0; i < length; i++) {
+    output_sinks.push_back(sinks[i].as<OutputSink*>(allow_raw_pointers()));
+    options.push_back(parse_convert_options(output_options[i]));
+  }
+
+  if (options.empty())
+    return AVERROR(EINVAL);
+
+  return run_outputs(input, output_sinks, options);
+}
+
+int Transcoder::run_outputs(InputSource& input, const std::vector<OutputSink*>& sinks, const std::vector<ConvertOptions>& options) {
+  av_log_set_level(options[0].verbose ? AV_LOG_VERBOSE : AV_LOG_QUIET);
+
+  int ret;
+
+  for (const ConvertOptions& output_options : options) {
+    if ((ret = check_extra_options(output_options)) < 0)
+      return ret;
+  }
+
+  reset();
+  begin_job(sinks, options);
+  // the input buffer was placed in the heap for this job
+  stats.heap_baseline -= input.get_heap_size();
+
+  if ((ret = open_input(input)) >= 0 &&
+      (ret = check_memory_budget()) >= 0 &&
+      (ret = seek_input(options[0])) >= 0 &&
+      (ret = open_outputs()) >= 0)
+    ret = transcode();
+
+  // releases the contexts of the job whether it succeeded or not, the outputs
+  // were flushed with their trailers
+  reset();
+  frame_pool.trim();
+
+  return ret < 0 ? ret : 0;
+}
+
+// Joins the files listed in a concat demuxer script at `list_path` (on the
+// emscripten FS) into a single output without re-encoding them. They must all
+// share the same codecs and parameters, like the segments of a split job.
+int Transcoder::concat(const string& list_path, OutputSink& output, val opts) {
+  ConvertOptions options = parse_convert_options(opts);
+
+  av_log_set_level(options.verbose ? AV_LOG_VERBOSE : AV_LOG_QUIET);
+
+  int ret = check_extra_options(options);
+
+  if (ret < 0)
+    return ret;
+
+  reset();
+  begin_job({ &output }, { options });
+
+  AVDictionary* demuxer_opts = NULL;
+
+  // the listed paths are absolute, which the demuxer refuses by default
+  av_dict_set(&demuxer_opts, "safe", "0", 0);
+
+  ret = avformat_open_input(&ifmt_ctx, list_path.c_str(), av_find_input_format("concat"), &demuxer_opts);
+  av_dict_free(&demuxer_opts);
+
+  if (ret < 0)
+    av_log(NULL, AV_LOG_ERROR, "Cannot open the concat list\n");
+  else if ((ret = avformat_find_stream_info(ifmt_ctx, NULL)) < 0)
+    av_log(NULL, AV_LOG_ERROR, "Cannot find stream information\n");
+  else
+    ret = avformat_alloc_output_context2(&outputs[0].fmt_ctx, NULL, options.output_format.c_str(), NULL);
+
+  if (ret >= 0) {
+    streams.resize(ifmt_ctx->nb_streams);
+
+    for (unsigned i = 0; i < ifmt_ctx->nb_streams && ret >= 0; i++) {
+      streams[i].in_index = i;
+
+      if (is_mapped_type(outputs[0], ifmt_ctx->streams[i]->codecpar->codec_type))
+        ret = open_copy_stream(streams[i], 0);
+    }
+  }
+
+  if (ret >= 0 &&
+      (ret = open_output_io(outputs[0])) >= 0)
+    ret = transcode();
+
+  reset();
+
+  return ret < 0 ? ret : 0;
+}
+
+// Whether a job with `opts` would copy the video stream rather than encode it,
+// whatever its preset. The auto preset would only cost a trial encode then.
+// Only the headers of the input are read.
+bool Transcoder::copies_video(InputSource& input, val opts) {
+  ConvertOptions options = parse_convert_options(opts);
+
+  options.preset.clear();
+
+  reset();
+  outputs.resize(1);
+  outputs[0].options = options;
+
+  bool copies = false;
+
+  if (open_input_context(input, &ifmt_ctx, &input_io) >= 0 &&
+      avformat_alloc_output_context2(&outputs[0].fmt_ctx, NULL, options.output_format.c_str(), NULL) >= 0 &&
+      is_mapped_type(outputs[0], AVMEDIA_TYPE_VIDEO)) {
+    int index = av_find_best_stream(ifmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+
+    if (index >= 0) {
+      StreamContext sc;
+      sc.in_index = index;
+      copies = can_copy_stream(sc, 0, options.video_encoder);
+    }
+  }
+
+  reset();
+
+  return copies;
+}
+
+void Transcoder::begin_job(const std::vector<OutputSink*>& sinks, const std::vector<ConvertOptions>& options) {
+  outputs.resize(sinks.size());
+
+  for (size_t i = 0; i < sinks.size(); i++) {
+    outputs[i].sink = sinks[i];
+    outputs[i].options = options[i];
+  }
+
+  on_progress = options[0].on_progress;
+  progress_interval = options[0].progress_interval;
+  started_at = reported_at = emscripten_get_now();
+  stats = JobStats();
+  position = 0;
+  cancelled = false;
+  memory_limit = options[0].memory_limit;
+  stats.heap_baseline = (unsigned) mallinfo().uordblks;
+  // every output may have a video encoder
+  codec_threads = get_codec_thread_count((int) outputs.size());
+  threads_left = THREAD_POOL_SIZE;
+}
+
+// Hands the progress of the job to its `onProgress` callback, which may
+// return true to cancel it.
+void Transcoder::report_progress(bool force) {
+  if (on_progress.isUndefined() || on_progress.isNull())
+    return;
+
+  double now = emscripten_get_now();
+
+  if (!force && now - reported_at < progress_interval)
+    return;
+
+  reported_at = now;
+
+  double elapsed = (now - started_at) / 1000;
+  double duration = ifmt_ctx && ifmt_ctx->duration != AV_NOPTS_VALUE
+    ? ifmt_ctx->duration / (double) AV_TIME_BASE
+    : 0;
+  double bytes = 0;
+
+  for (const OutputContext& output : outputs)
+    bytes += output.sink->bytes_written();
+
+  val progress = val::object();
+  progress.set("packets", (double) stats.packets_read);
+  progress.set("frames", (double) stats.video_frames);
+  progress.set("time", position);
+  progress.set("duration", duration);
+  progress.set("fps", elapsed > 0 ? stats.video_frames / elapsed : 0);
+  progress.set("bytes", bytes);
+
+  if (on_progress(progress).as<bool>())
+    cancelled = true;
+}
+
+// Stats of the last job, times are in seconds like the metrics in JS.
+val Transcoder::get_stats() const {
+  val result = val::object();
+
+  result.set("demuxTime", stats.stage_time[STAGE_DEMUX] / 1000);
+  result.set("decodeTime", stats.stage_time[STAGE_DECODE] / 1000);
+  result.set("filterTime", stats.stage_time[STAGE_FILTER] / 1000);
+  result.set("encodeTime", stats.stage_time[STAGE_ENCODE] / 1000);
+  result.set("muxTime", stats.stage_time[STAGE_MUX] / 1000);
+  result.set("packetsRead", (double) stats.packets_read);
+  result.set("packetsWritten", (double) stats.packets_written);
+  result.set("framesDecoded", (double) stats.frames_decoded);
+  result.set("framesEncoded", (double) stats.frames_encoded);
+  result.set("bytesRead", (double) stats.bytes_read);
+  result.set("peakHeap", (double) stats.peak_heap);
+
+  return result;
+}
+
+void Transcoder::reset() {
+  for (StreamContext& sc : streams) {
+    avcodec_free_context(&sc.dec_ctx);
+    avfilter_graph_free(&sc.filter_graph);
+
+    for (EncoderContext& ec : sc.encoders)
+      avcodec_free_context(&ec.enc_ctx);
+  }
+
+  streams.clear();
+
+  close_input_context(&ifmt_ctx, &input_io);
+
+  for (OutputContext& output : outputs) {
+    avformat_free_context(output.fmt_ctx);
+
+    // a failed or cancelled job leaves whatever is still buffered unwritten,
+    // the sink would only get a broken piece of output
+    if (output.io) {
+      av_freep(&output.io->buffer);
+      avio_context_free(&output.io);
+    }
+  }
+
+  outputs.clear();
+
+  av_packet_unref(packet);
+  av_packet_unref(enc_packet);
+  av_packet_unref(copy_packet_ref);
+  av_frame_unref(frame);
+  av_frame_unref(filt_frame);
+
+  on_progress = val::undefined();
+}
+
+int Transcoder::open_input(InputSource& input) {
+  int ret;
+
+  if ((ret = open_input_context(input, &ifmt_ctx, &input_io)) < 0)
+    return ret;
+
+  streams.resize(ifmt_ctx->nb_streams);
+
+  for (unsigned i = 0; i < ifmt_ctx->nb_streams; i++)
+    streams[i].in_index = i;
+
+  // same as ffmpeg's default mapping, only the best video and audio streams
+  // make it to the output
+  for (AVMediaType type : { AVMEDIA_TYPE_VIDEO, AVMEDIA_TYPE_AUDIO }) {
+    int index = av_find_best_stream(ifmt_ctx, type, -1, -1, NULL, 0);
+
+    if (index < 0)
+      continue;
+
+    if ((ret = open_decoder(streams[index])) < 0)
+      return ret;
+  }
+
+  return 0;
+}
+
+int Transcoder::open_decoder(StreamContext& sc) {
+  AVStream* stream = ifmt_ctx->streams[sc.in_index];
+  const AVCodec* decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+
+  if (!decoder) {
+    av_log(NULL, AV_LOG_ERROR, "Failed to find decoder for stream #%d\n", sc.in_index);
+    return AVERROR_DECODER_NOT_FOUND;
+  }
+
+  if (!(sc.dec_ctx = avcodec_alloc_context3(decoder)))
+    return AVERROR(ENOMEM);
+
+  int ret;
+
+  if ((ret = avcodec_parameters_to_context(sc.dec_ctx, stream->codecpar)) < 0)
+    return ret;
+
+  sc.dec_ctx->pkt_timebase = stream->time_base;
+
+  if (sc.dec_ctx->codec_type == AVMEDIA_TYPE_VIDEO)
+    sc.dec_ctx->framerate = av_guess_frame_rate(ifmt_ctx, stream, NULL);
+
+  // lavc picks frame threading when the decoder supports it, slices otherwise.
+  // Audio is cheap to decode, it isn't worth threads out of the pool.
+  sc.dec_ctx->thread_count = sc.dec_ctx->codec_type == AVMEDIA_TYPE_VIDEO ? codec_threads : 1;
+  sc.dec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+  threads_left -= get_spawned_threads(sc.dec_ctx->thread_count, false);
+
+  if (sc.dec_ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+    sc.dec_ctx->opaque = &frame_pool;
+    sc.dec_ctx->get_buffer2 = &FramePool::get_buffer;
+#if LIBAVCODEC_VERSION_MAJOR < 59
+    // the pool takes a lock, so frame threads may call it directly
+    sc.dec_ctx->thread_safe_callbacks = 1;
+#endif
+  }
+
+  if ((ret = avcodec_open2(sc.dec_ctx, decoder, NULL)) < 0) {
+    av_log(NULL, AV_LOG_ERROR, "Failed to open decoder for stream #%d\n", sc.in_index);
+    return ret;
+  }
+
+  return 0;
+}
+
+int Transcoder::seek_input(const ConvertOptions& options) {
+  for (StreamContext& sc : streams) {
+    double time_base = av_q2d(ifmt_ctx->streams[sc.in_index]->time_base);
+
+    if (options.start_time >= 0)
+      sc.start_pts = llrint(options.start_time / time_base);
+    if (options.end_time >= 0)
+      sc.end_pts = llrint(options.end_time / time_base);
+  }
+
+  if (options.start_time <= 0)
+    return 0;
+
+  int index = av_find_best_stream(ifmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+  int64_t timestamp = index >= 0
+    ? streams[index].start_pts
+    : llrint(options.start_time * AV_TIME_BASE);
+
+  // decoding has to restart from a keyframe, the frames before the range are
+  // dropped once decoded
+  int ret = av_seek_frame(ifmt_ctx, index, timestamp, AVSEEK_FLAG_BACKWARD);
+
+  if (ret < 0)
+    av_log(NULL, AV_LOG_ERROR, "Cannot seek to %f\n", options.start_time);
+
+  return ret;
+}
+
+// Size of the frames a rendition encodes out of `width`x`height` ones, the same
+// as the scale of get_branch_filter
+void get_output_size(const ConvertOptions& options, int width, int height, int* out_width, int* out_height) {
+  double aspect = height > 0 ? (double) width / height : 1;
+
+  if (options.width > 0 || options.height > 0) {
+    *out_width = options.width > 0 ? options.width : (int) (options.height * aspect);
+    *out_height = options.height > 0 ? options.height : (int) (options.width / aspect);
+    return;
+  }
+
+  double scale = 1;
+
+  if (options.max_width > 0 && width > options.max_width)
+    scale = FFMIN(scale, (double) options.max_width / width);
+  if (options.max_height > 0 && height > options.max_height)
+    scale = FFMIN(scale, (double) options.max_height / height);
+
+  *out_width = (int) (width * scale);
+  *out_height = (int) (height * scale);
+}
+
+// Refuses the job upfront, once the input is open and before any encoder or
+// output is, when the heap it already takes plus what its video frames will is
+// over the memory limit. The frames are counted generously: the references a
+// decoder keeps plus one per thread, and as many again for each rendition that
+// may encode the video, queued in its branch of the filter graph and its
+// encoder. The encoders' frames are taken as yuv420p, which most of them use.
+// Decoded frames the pool kept from earlier jobs cost nothing new.
+int Transcoder::check_memory_budget() {
+  if (memory_limit <= 0)
+    return 0;
+
+  double needed = stats.get_heap_used();
+
+  for (const StreamContext& sc : streams) {
+    if (!sc.dec_ctx || sc.dec_ctx->codec_type != AVMEDIA_TYPE_VIDEO)
+      continue;
+
+    int height = sc.dec_ctx->height;
+    int linesizes[4];
+    int frame_size = FramePool::get_frame_size(sc.dec_ctx, sc.dec_ctx->pix_fmt, sc.dec_ctx->width, &height, linesizes);
+
+    if (frame_size > 0) {
+      int frames = MAX_REFERENCE_FRAMES + sc.dec_ctx->thread_count - frame_pool.allocated(frame_size);
+      needed += (double) frame_size * FFMAX(frames, 0);
+    }
+
+    for (const OutputContext& output : outputs) {
+      const ConvertOptions& options = output.options;
+      const AVOutputFormat* format = av_guess_format(options.output_format.c_str(), NULL, NULL);
+
+      // copied or left out of the output, the video isn't encoded
+      if (options.video_encoder == "copy" || (format && format->video_codec == AV_CODEC_ID_NONE))
+        continue;
+
+      int out_width, out_height;
+      get_output_size(options, sc.dec_ctx->width, sc.dec_ctx->height, &out_width, &out_height);
+      frame_size = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, out_width, out_height, 32);
+
+      if (frame_size > 0)
+        needed += (double) frame_size * (MAX_REFERENCE_FRAMES + codec_threads);
+    }
+  }
+
+  if (needed > memory_limit) {
+    av_log(NULL, AV_LOG_ERROR, "The job needs about %.0f MiB, over the limit of %.0f MiB\n",
+      needed / (1 << 20), memory_limit / (1 << 20));
+    return AVERROR(ENOMEM);
+  }
+
+  return 0;
+}
+
+// Maps the decoded streams to every output, then builds one filter graph per
+// stream that feeds all of its renditions, and finally writes the headers.
+int Transcoder::open_outputs() {
+  int ret;
+
+  for (OutputContext& output : outputs) {
+    const char* format = output.options.output_format.c_str();
+
+    if ((ret = avformat_alloc_output_context2(&output.fmt_ctx, NULL, format, NULL)) < 0) {
+      av_log(NULL, AV_LOG_ERROR, "Unknown output format '%s'\n", format);
+      return ret;
+    }
+  }
+
+  for (StreamContext& sc : streams) {
+    if (!sc.dec_ctx)
+      continue;
+
+    for (size_t i = 0; i < outputs.size(); i++) {
+      if ((ret = map_stream(sc, i)) < 0)
+        return ret;
+    }
+
+    // copied packets skip the decoder, which is only needed as a marker of
+    // the selected streams up to here
+    if (sc.encoders.empty()) {
+      avcodec_free_context(&sc.dec_ctx);
+      continue;
+    }
+
+    // the filter graph is configured first, so the encoders can be opened
+    // with whatever its outputs negotiated
+    if ((ret = init_filters(sc)) < 0)
+      return ret;
+
+    for (EncoderContext& ec : sc.encoders) {
+      if ((ret = open_encoder(sc, ec)) < 0)
+        return ret;
+    }
+  }
+
+  for (OutputContext& output : outputs) {
+    if ((ret = open_output_io(output)) < 0 ||
+        (ret = check_unused_options(output)) < 0)
+      return ret;
+  }
+
+  return 0;
+}
+
+// Whether an option is meant for one of the encoders of the output, or for
+// its muxer, rather than for a type of stream the output only copies or
+// doesn't have. Options without a stream specifier go by the stream types
+// their AVOption is flagged for.
+bool is_option_for_output(const OutputContext& output, const ExtraOption& option) {
+  if (option.stream_type)
+    return output.encoded_types.count(option.stream_type);
+
+  const AVClass* codec_class = avcodec_get_class();
+  const AVOption* codec_option = av_opt_find(&codec_class, option.key.c_str(), NULL, 0,
+    AV_OPT_SEARCH_FAKE_OBJ | AV_OPT_SEARCH_CHILDREN);
+
+  // only a muxer has it
+  if (!codec_option)
+    return true;
+
+  return ((codec_option->flags & AV_OPT_FLAG_VIDEO_PARAM) && output.encoded_types.count('v')) ||
+    ((codec_option->flags & AV_OPT_FLAG_AUDIO_PARAM) && output.encoded_types.count('a'));
+}
+
+// Deals with the options of `extraOptions` that none of the encoders nor the
+// muxer of the output took, which would otherwise be dropped silently. Like
+// ffmpeg, options for streams that are copied or missing only get a warning,
+// e.g. `-b:a` on an input without audio, while the others fail the job.
+int Transcoder::check_unused_options(const OutputContext& output) {
+  for (const ExtraOption& option : output.options.extra_options) {
+    if (output.used_options.count(option.key))
+      continue;
+
+    string name = option.stream_type
+      ? "-" + option.key + ":" + option.stream_type
+      : "-" + option.key;
+
+    if (!is_option_for_output(output, option)) {
+      av_log(NULL, AV_LOG_WARNING, "Option '%s' was not used by any stream\n", name.c_str());
+      continue;
+    }
+
+    av_log(NULL, AV_LOG_ERROR, "Option '%s' is not supported by the encoders or the muxer\n", name.c_str());
+
+    return AVERROR_OPTION_NOT_FOUND;
+  }
+
+  return 0;
+}
+
+// Decides whether a decoded stream is copied to an output, encoded for it or
+// left out of it.
+int Transcoder::map_stream(StreamContext& sc, int output) {
+  AVMediaType type = sc.dec_ctx->codec_type;
+  const ConvertOptions& options = outputs[output].options;
+
+  if (!is_mapped_type(outputs[output], type))
+    return 0;
+
+  const string& encoder_name = type == AVMEDIA_TYPE_VIDEO
+    ? options.video_encoder
+    : options.audio_encoder;
+
+  if (can_copy_stream(sc, output, encoder_name))
+    return open_copy_stream(sc, output);
+
+  return add_encoder(sc, output, encoder_name);
+}
+
+// Like ffmpeg, the "copy" encoder always copies the stream and leaves it to
+// the muxer to reject it. Otherwise `stream_copy` only copies streams that are
+// already encoded with the requested codec, when the muxer is known to accept
+// it and nothing asks for an actual encode.
+bool Transcoder::can_copy_stream(const StreamContext& sc, int output, const string& encoder_name) const {
+  const ConvertOptions& options = outputs[output].options;
+
+  if (encoder_name == "copy")
+    return true;
+
+  if (!options.stream_copy)
+    return false;
+
+  const AVStream* stream = ifmt_ctx->streams[sc.in_index];
+  const AVCodec* encoder = avcodec_find_encoder_by_name(encoder_name.c_str());
+
+  if (!encoder || encoder->id != stream->codecpar->codec_id ||
+      avformat_query_codec(outputs[output].fmt_ctx->oformat, encoder->id, FF_COMPLIANCE_NORMAL) != 1)
+    return false;
+
+  if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+    // rotation is baked into the re-encoded frames, but not every muxer keeps
+    // the display matrix of a copied stream
+    if (get_rotation_filter(stream) != "null")
+      return false;
+
+    if (options.width > 0 || options.height > 0)
+      return false;
+
+    if ((options.max_width > 0 && stream->codecpar->width > options.max_width) ||
+        (options.max_height > 0 && stream->codecpar->height > options.max_height))
+      return false;
+
+    if (!options.preset.empty() || !options.tune.empty() || options.crf >= 0 || options.gop > 0)
+      return false;
+  }
+
+  // encoder options (bitrate, crf...) only make sense when re-encoding
+  char stream_type = get_stream_type(stream->codecpar->codec_type);
+
+  for (const ExtraOption& option : options.extra_options) {
+    if (option.stream_type == stream_type)
+      return false;
+  }
+
+  return true;
+}
+
+int Transcoder::open_output_io(OutputContext& output) {
+  AVFormatContext* ofmt_ctx = output.fmt_ctx;
+
+  if (!ofmt_ctx->nb_streams) {
+    av_log(NULL, AV_LOG_ERROR, "Output file does not contain any stream\n");
+    return AVERROR_STREAM_NOT_FOUND;
+  }
+
+  uint8_t* buffer = (uint8_t*) av_malloc(IO_BUFFER_SIZE);
+
+  if (!buffer)
+    return AVERROR(ENOMEM);
+
+  output.io = avio_alloc_context(buffer, IO_BUFFER_SIZE, 1, output.sink, NULL,
+    &OutputSink::write_callback, output.sink->is_streaming() ? NULL : &OutputSink::seek_callback);
+
+  if (!output.io) {
+    av_free(buffer);
+    return AVERROR(ENOMEM);
+  }
+
+  ofmt_ctx->pb = output.io;
+  ofmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+  AVDictionary* muxer_opts = build_dictionary(output.options.extra_options, 0);
+
+  // the moov atom can't be patched in once the data has been handed out, so
+  // mp4/mov streams are written as fragments
+  if (output.sink->is_streaming() &&
+      av_opt_find((void*) &ofmt_ctx->oformat->priv_class, "movflags", NULL, 0, AV_OPT_SEARCH_FAKE_OBJ))
+    av_dict_set(&muxer_opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", AV_DICT_DONT_OVERWRITE);
+
+  int ret;
+
+  {
+    StageTimer timer(stats, STAGE_MUX);
+    ret = avformat_write_header(ofmt_ctx, &muxer_opts);
+  }
+
+  mark_used_options(output.options.extra_options, 0, muxer_opts, output.used_options);
+  av_dict_free(&muxer_opts);
+
+  if (ret < 0)
+    av_log(NULL, AV_LOG_ERROR, "Error occurred when writing the output header\n");
+
+  return ret;
+}
+
+int Transcoder::add_encoder(StreamContext& sc, int output, const string& encoder_name) {
+  const AVCodec* encoder = avcodec_find_encoder_by_name(encoder_name.c_str());
+
+  if (!encoder || encoder->type != sc.dec_ctx->codec_type) {
+    av_log(NULL, AV_LOG_ERROR, "Unknown encoder '%s'\n", encoder_name.c_str());
+    return AVERROR_ENCODER_NOT_FOUND;
+  }
+
+  EncoderContext ec;
+  ec.output = output;
+
+  if (!(ec.enc_ctx = avcodec_alloc_context3(encoder)))
+    return AVERROR(ENOMEM);
+
+  sc.encoders.push_back(ec);
+
+  return 0;
+}
+
+int Transcoder::open_encoder(StreamContext& sc, EncoderContext& ec) {
+  AVCodecContext* enc_ctx = ec.enc_ctx;
+  AVFilterContext* sink = ec.buffersink_ctx;
+  AVFormatContext* ofmt_ctx = outputs[ec.output].fmt_ctx;
+  const ConvertOptions& options = outputs[ec.output].options;
+  const AVCodec* encoder = enc_ctx->codec;
+  AVMediaType type = enc_ctx->codec_type;
+
+  if (type == AVMEDIA_TYPE_VIDEO) {
+    AVRational frame_rate = av_buffersink_get_frame_rate(sink);
+
+    if (!frame_rate.num)
+      frame_rate = sc.dec_ctx->framerate;
+    if (!frame_rate.num)
+      frame_rate = { 25, 1 };
+
+    // the MPEG-4 standard caps the time base denominator
+    if (encoder->id == AV_CODEC_ID_MPEG4)
+      av_reduce(&frame_rate.num, &frame_rate.den, frame_rate.num, frame_rate.den, 65535);
+
+    enc_ctx->width = av_buffersink_get_w(sink);
+    enc_ctx->height = av_buffersink_get_h(sink);
+    enc_ctx->pix_fmt = (AVPixelFormat) av_buffersink_get_format(sink);
+    enc_ctx->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(sink);
+    enc_ctx->framerate = frame_rate;
+    enc_ctx->time_base = av_inv_q(frame_rate);
+  } else {
+    enc_ctx->sample_rate = av_buffersink_get_sample_rate(sink);
+    enc_ctx->channel_layout = av_buffersink_get_channel_layout(sink);
+    enc_ctx->channels = av_buffersink_get_channels(sink);
+    enc_ctx->sample_fmt = (AVSampleFormat) av_buffersink_get_format(sink);
+    enc_ctx->time_base = { 1, enc_ctx->sample_rate };
+  }
+
+  if (ofmt_ctx->oformat->flags & AVFMT_GLOBALHEADER)
+    enc_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  if (encoder->capabilities & AV_CODEC_CAP_EXPERIMENTAL)
+    enc_ctx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+
+  // also becomes x264's frame threads (and its lookahead threads with them)
+  enc_ctx->thread_count = type == AVMEDIA_TYPE_VIDEO ? codec_threads : 1;
+
+  int threads = get_spawned_threads(enc_ctx->thread_count, encoder->id == AV_CODEC_ID_H264);
+
+  if (threads > threads_left) {
+    av_log(NULL, AV_LOG_ERROR, "Not enough threads left for encoder '%s', %d needed out of %d\n",
+      encoder->name, threads, threads_left);
+    return AVERROR(EAGAIN);
+  }
+
+  threads_left -= threads;
+
+  AVDictionary* encoder_opts = build_dictionary(options.extra_options, get_stream_type(type));
+
+  if (type == AVMEDIA_TYPE_VIDEO)
+    apply_video_presets(options, enc_ctx, &encoder_opts);
+
+  outputs[ec.output].encoded_types.insert(get_stream_type(type));
+
+  int ret = avcodec_open2(enc_ctx, encoder, &encoder_opts);
+  mark_used_options(options.extra_options, get_stream_type(type), encoder_opts, outputs[ec.output].used_options);
+  av_dict_free(&encoder_opts);
+
+  if (ret < 0) {
+    av_log(NULL, AV_LOG_ERROR, "Cannot open encoder '%s'\n", encoder->name);
+    return ret;
+  }
+
+  if (type == AVMEDIA_TYPE_AUDIO && enc_ctx->frame_size &&
+      !(encoder->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+    av_buffersink_set_frame_size(sink, enc_ctx->frame_size);
+
+  AVStream* out_stream = avformat_new_stream(ofmt_ctx, NULL);
+
+  if (!out_stream)
+    return AVERROR(ENOMEM);
+
+  if ((ret = avcodec_parameters_from_context(out_stream->codecpar, enc_ctx)) < 0)
+    return ret;
+
+  out_stream->time_base = enc_ctx->time_base;
+  ec.out_index = out_stream->index;
+
+  return 0;
+}
+
+int Transcoder::open_copy_stream(StreamContext& sc, int output) {
+  AVStream* in_stream = ifmt_ctx->streams[sc.in_index];
+  AVStream* out_stream = avformat_new_stream(outputs[output].fmt_ctx, NULL);
+
+  if (!out_stream)
+    return AVERROR(ENOMEM);
+
+  int ret;
+
+  if ((ret = avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar)) < 0)
+    return ret;
+
+  // tags are container specific, let the muxer pick its own
+  out_stream->codecpar->codec_tag = 0;
+  out_stream->time_base = in_stream->time_base;
+
+  // carries the display matrix of rotated videos over, among others
+  for (int i = 0; i < in_stream->nb_side_data; i++) {
+    const AVPacketSideData& side_data = in_stream->side_data[i];
+    uint8_t* data = av_stream_new_side_data(out_stream, side_data.type, side_data.size);
+
+    if (!data)
+      return AVERROR(ENOMEM);
+
+    memcpy(data, side_data.data, side_data.size);
+  }
+
+  sc.copies.push_back({ output, out_stream->index });
+
+  return 0;
+}
+
+// What a rendition does to the frames on its own, after the rotation that's
+// shared by all of them
+string Transcoder::get_branch_filter(const StreamContext& sc, const EncoderContext& ec) const {
+  const ConvertOptions& options = outputs[ec.output].options;
+
+  if (sc.dec_ctx->codec_type != AVMEDIA_TYPE_VIDEO)
+    return "anull";
+
+  if (options.width <= 0 && options.height <= 0) {
+    if (options.max_width <= 0 && options.max_height <= 0)
+      return "null";
+
+    // only ever scales down, to an even size for the same reason as below
+    string max_width = options.max_width > 0 ? std::to_string(options.max_width) : "iw";
+    string max_height = options.max_height > 0 ? std::to_string(options.max_height) : "ih";
+
+    return "scale=w='min(iw," + max_width + ")':h='min(ih," + max_height + ")'" +
+      ":force_original_aspect_ratio=decrease:force_divisible_by=2";
+  }
+
+  // a missing side follows the aspect ratio, rounded to an even size for the
+  // sake of yuv420p encoders
+  return "scale=" + std::to_string(options.width > 0 ? options.width : -2) +
+    ":" + std::to_string(options.height > 0 ? options.height : -2);
+}
+
+// Builds `in -> rotation -> split -> (scale -> out<i>)...` for video, or the
+// same with asplit for audio, each out<i> being constrained to the formats of
+// the matching encoder. The split is left out when there's a single encoder.
+int Transcoder::init_filters(StreamContext& sc) {
+  AVCodecContext* dec_ctx = sc.dec_ctx;
+  AVStream* in_stream = ifmt_ctx->streams[sc.in_index];
+  AVRational time_base = in_stream->time_base;
+  bool is_video = dec_ctx->codec_type == AVMEDIA_TYPE_VIDEO;
+
+  if (!(sc.filter_graph = avfilter_graph_alloc()))
+    return AVERROR(ENOMEM);
+
+  // libavfilter would start a slice thread for every core in each graph,
+  // which the thread budget of the job leaves no room for
+  sc.filter_graph->nb_threads = 1;
+
+  char args[512];
+  string spec;
+  int ret;
+
+  if (is_video) {
+    AVRational sar = dec_ctx->sample_aspect_ratio;
+
+    if (!sar.den)
+      sar = { 0, 1 };
+
+    snprintf(args, sizeof(args),
+      "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+      dec_ctx->width, dec_ctx->height, dec_ctx->pix_fmt,
+      time_base.num, time_base.den, sar.num, sar.den);
+
+    if (dec_ctx->framerate.num) {
+      size_t length = strlen(args);
+
+      snprintf(args + length, sizeof(args) - length, ":frame_rate=%d/%d",
+        dec_ctx->framerate.num, dec_ctx->framerate.den);
+    }
+
+    ret = avfilter_graph_create_filter(&sc.buffersrc_ctx, avfilter_get_by_name("buffer"), "in", args, NULL, sc.filter_graph);
+    if (ret < 0)
+      return ret;
+
+    spec = get_rotation_filter(in_stream);
+  } else {
+    uint64_t channel_layout = dec_ctx->channel_layout
+      ? dec_ctx->channel_layout
+      : av_get_default_channel_layout(dec_ctx->channels);
+
+    snprintf(args, sizeof(args),
+      "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
+      time_base.num, time_base.den, dec_ctx->sample_rate,
+      av_get_sample_fmt_name(dec_ctx->sample_fmt), channel_layout);
+
+    ret = avfilter_graph_create_filter(&sc.buffersrc_ctx, avfilter_get_by_name("abuffer"), "in", args, NULL, sc.filter_graph);
+    if (ret < 0)
+      return ret;
+
+    spec = "anull";
+  }
+
+  size_t count = sc.encoders.size();
+  AVFilterInOut* sinks = NULL;
+
+  spec = "[in]" + spec;
+
+  if (count > 1) {
+    spec += string(is_video ? ",split=" : ",asplit=") + std::to_string(count);
+
+    for (size_t i = 0; i < count; i++)
+      spec += "[branch" + std::to_string(i) + "]";
+  }
+
+  // the sinks are listed in reverse, so `sinks` ends up in their order
+  for (size_t i = count; i-- > 0;) {
+    EncoderContext& ec = sc.encoders[i];
+    const AVCodec* encoder = ec.enc_ctx->codec;
+    string name = "out" + std::to_string(i);
+
+    ret = avfilter_graph_create_filter(&ec.buffersink_ctx, avfilter_get_by_name(is_video ? "buffersink" : "abuffersink"),
+      name.c_str(), NULL, NULL, sc.filter_graph);
+    if (ret < 0)
+      break;
+
+    if (is_video && encoder->pix_fmts) {
+      AVPixelFormat pix_fmts[] = {
+        avcodec_find_best_pix_fmt_of_list(encoder->pix_fmts, dec_ctx->pix_fmt, 0, NULL),
+        AV_PIX_FMT_NONE
+      };
+
+      ret = av_opt_set_int_list(ec.buffersink_ctx, "pix_fmts", pix_fmts, AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
+    } else if (!is_video) {
+      uint64_t channel_layout = dec_ctx->channel_layout
+        ? dec_ctx->channel_layout
+        : av_get_default_channel_layout(dec_ctx->channels);
+      AVSampleFormat sample_fmts[] = { select_sample_fmt(encoder, dec_ctx->sample_fmt), AV_SAMPLE_FMT_NONE };
+      int sample_rates[] = { select_sample_rate(encoder, dec_ctx->sample_rate), -1 };
+      int64_t channel_layouts[] = { (int64_t) select_channel_layout(encoder, channel_layout), -1 };
+
+      if ((ret = av_opt_set_int_list(ec.buffersink_ctx, "sample_fmts", sample_fmts, AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN)) >= 0 &&
+          (ret = av_opt_set_int_list(ec.buffersink_ctx, "sample_rates", sample_rates, -1, AV_OPT_SEARCH_CHILDREN)) >= 0)
+        ret = av_opt_set_int_list(ec.buffersink_ctx, "channel_layouts", channel_layouts, -1, AV_OPT_SEARCH_CHILDREN);
+    }
+
+    if (ret < 0)
+      break;
+
+    AVFilterInOut* sink = avfilter_inout_alloc();
+
+    if (!sink) {
+      ret = AVERROR(ENOMEM);
+      break;
+    }
+
+    sink->name = av_strdup(name.c_str());
+    sink->filter_ctx = ec.buffersink_ctx;
+    sink->pad_idx = 0;
+    sink->next = sinks;
+    sinks = sink;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    string branch = get_branch_filter(sc, sc.encoders[i]);
+
+    spec += count > 1
+      ? ";[branch" + std::to_string(i) + "]" + branch
+      : "," + branch;
+    spec += "[out" + std::to_string(i) + "]";
+  }
+
+  AVFilterInOut* source = avfilter_inout_alloc();
+
+  if (ret >= 0 && !source)
+    ret = AVERROR(ENOMEM);
+
+  if (ret >= 0) {
+    source->name = av_strdup("in");
+    source->filter_ctx = sc.buffersrc_ctx;
+    source->pad_idx = 0;
+    source->next = NULL;
+
+    ret = avfilter_graph_parse_ptr(sc.filter_graph, spec.c_str(), &sinks, &source, NULL);
+  }
+
+  if (ret >= 0)
+    ret = avfilter_graph_config(sc.filter_graph, NULL);
+
+  avfilter_inout_free(&sinks);
+  avfilter_inout_free(&source);
+
+  return ret;
+}
+
+// Video and audio go to an output unless its muxer has no use for that kind
+// of stream (e.g. audio in a gif).
+bool Transcoder::is_mapped_type(const OutputContext& output, AVMediaType type) const {
+  if (type == AVMEDIA_TYPE_VIDEO)
+    return output.fmt_ctx->oformat->video_codec != AV_CODEC_ID_NONE;
+  if (type == AVMEDIA_TYPE_AUDIO)
+    return output.fmt_ctx->oformat->audio_codec != AV_CODEC_ID_NONE;
+
+  return false;
+}
+
+// Copied packets can't be trimmed to the range like decoded frames, so the
+// ones that start before it are dropped whole.
+bool Transcoder::is_before_start(StreamContext& sc, const AVPacket* pkt) const {
+  return sc.start_pts != AV_NOPTS_VALUE && pkt->pts != AV_NOPTS_VALUE && pkt->pts < sc.start_pts;
+}
+
+// A stream is done with once a packet past the end of the range shows up. For
+// video that has to be a keyframe, since packets come in decode order and the
+// ones before it may still hold frames that belong to the range.
+bool Transcoder::is_past_end(StreamContext& sc, const AVPacket* pkt) const {
+  if (sc.end_pts == AV_NOPTS_VALUE || pkt->pts == AV_NOPTS_VALUE || pkt->pts < sc.end_pts)
+    return false;
+
+  return ifmt_ctx->streams[sc.in_index]->codecpar->codec_type != AVMEDIA_TYPE_VIDEO ||
+    (pkt->flags & AV_PKT_FLAG_KEY);
+}
+
+int Transcoder::transcode() {
+  int ret;
+
+  while ((ret = read_packet()) >= 0) {
+    StreamContext& sc = streams[packet->stream_index];
+
+    if (cancelled) {
+      av_packet_unref(packet);
+      return AVERROR_EXIT;
+    }
+
+    if (!sc.finished && is_past_end(sc, packet))
+      sc.finished = true;
+
+    if (!sc.finished && sc.is_mapped()) {
+      AVStream* stream = ifmt_ctx->streams[sc.in_index];
+
+      if (packet->pts != AV_NOPTS_VALUE) {
+        int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        position = FFMAX(position, (packet->pts - start) * av_q2d(stream->time_base));
+      }
+
+      // copied video packets are frames too, counted for the first output
+      // like the encoded ones
+      if (!sc.copies.empty() && sc.copies[0].output == 0 &&
+          stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        stats.video_frames++;
+    }
+
+    ret = 0;
+
+    if (!sc.finished && !sc.encoders.empty())
+      ret = decode_packet(sc, packet);
+    if (ret >= 0 && !sc.finished && !sc.copies.empty() && !is_before_start(sc, packet))
+      ret = copy_packet(sc, packet);
+
+    av_packet_unref(packet);
+
+    if (ret < 0)
+      return ret;
+
+    bool finished = true;
+
+    for (const StreamContext& other : streams) {
+      if (other.is_mapped() && !other.finished)
+        finished = false;
+    }
+
+    // the rest of the input is past the end of the range
+    if (finished)
+      break;
+
+    report_progress(false);
+  }
+
+  if (ret < 0 && ret != AVERROR_EOF)
+    return ret;
+
+  // the last progress report may have asked to stop
+  if (cancelled)
+    return AVERROR_EXIT;
+
+  // drain the decoders, then the filter graphs and finally the encoders
+  for (StreamContext& sc : streams) {
+    if (sc.encoders.empty())
+      continue;
+
+    if ((ret = decode_packet(sc, NULL)) < 0 ||
+        (ret = filter_encode_write_frame(sc, NULL)) < 0)
+      return ret;
+
+    for (EncoderContext& ec : sc.encoders) {
+      if ((ret = encode_write_frame(sc, ec, NULL)) < 0)
+        return ret;
+    }
+  }
+
+  for (OutputContext& output : outputs) {
+    {
+      StageTimer timer(stats, STAGE_MUX);
+      ret = av_write_trailer(output.fmt_ctx);
+    }
+
+    if (ret < 0)
+      break;
+
+    // hands the rest of the output to the sink, only once it's complete
+    avio_flush(output.io);
+  }
+
+  stats.update_peak_heap();
+
+  if (ret < 0)
+    return ret;
+
+  report_progress(true);
+
+  return 0;
+}
+
+int Transcoder::read_packet() {
+  int ret;
+
+  {
+    StageTimer timer(stats, STAGE_DEMUX);
+    ret = av_read_frame(ifmt_ctx, packet);
+  }
+
+  if (ret >= 0) {
+    stats.packets_read++;
+    stats.bytes_read += packet->size;
+  }
+
+  if (stats.packets_read % HEAP_CHECK_INTERVAL == 0)
+    stats.update_peak_heap();
+
+  // the upfront estimate of check_memory_budget may fall short, this backstop
+  // is what binds
+  if (ret >= 0 && memory_limit > 0 && stats.peak_heap > memory_limit) {
+    av_log(NULL, AV_LOG_ERROR, "Memory limit of %.0f MiB exceeded\n", memory_limit / (1 << 20));
+    av_packet_unref(packet);
+    return AVERROR(ENOMEM);
+  }
+
+  return ret;
+}
+
+int Transcoder::decode_packet(StreamContext& sc, const AVPacket* pkt) {
+  int ret;
+
+  {
+    StageTimer timer(stats, STAGE_DECODE);
+    ret = avcodec_send_packet(sc.dec_ctx, pkt);
+  }
+
+  // like ffmpeg, a corrupt packet is skipped instead of failing the whole job
+  if (ret == AVERROR_INVALIDDATA) {
+    av_log(NULL, AV_LOG_WARNING, "Error decoding packet on stream #%d\n", sc.in_index);
+    return 0;
+  }
+
+  if (ret < 0)
+    return ret;
+
+  while (true) {
+    {
+      StageTimer timer(stats, STAGE_DECODE);
+      ret = avcodec_receive_frame(sc.dec_ctx, frame);
+    }
+
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+      return 0;
+    if (ret < 0)
+      return ret;
+
+    stats.frames_decoded++;
+
+    frame->pts = frame->best_effort_timestamp;
+
+    // frames outside of the range were only decoded as references
+    if (frame->pts != AV_NOPTS_VALUE &&
+        ((sc.start_pts != AV_NOPTS_VALUE && frame->pts < sc.start_pts) ||
+         (sc.end_pts != AV_NOPTS_VALUE && frame->pts >= sc.end_pts))) {
+      av_frame_unref(frame);
+      continue;
+    }
+
+    ret = filter_encode_write_frame(sc, frame);
+    av_frame_unref(frame);
+
+    if (ret < 0)
+      return ret;
+  }
+}
+
+// Each output gets its own reference to the packet, which only bumps the
+// refcount of its data
+int Transcoder::copy_packet(StreamContext& sc, const AVPacket* pkt) {
+  AVStream* in_stream = ifmt_ctx->streams[sc.in_index];
+
+  for (const CopyTarget& target : sc.copies) {
+    OutputContext& output = outputs[target.output];
+    AVStream* out_stream = output.fmt_ctx->streams[target.out_index];
+    int ret;
+
+    if ((ret = av_packet_ref(copy_packet_ref, pkt)) < 0)
+      return ret;
+
+    copy_packet_ref->stream_index = target.out_index;
+    copy_packet_ref->pos = -1;
+    av_packet_rescale_ts(copy_packet_ref, in_stream->time_base, out_stream->time_base);
+
+    if ((ret = write_packet(output, copy_packet_ref)) < 0)
+      return ret;
+  }
+
+  return 0;
+}
+
+// the muxer takes ownership of the packet reference
+int Transcoder::write_packet(OutputContext& output, AVPacket* pkt) {
+  StageTimer timer(stats, STAGE_MUX);
+
+  stats.packets_written++;
+
+  return av_interleaved_write_frame(output.fmt_ctx, pkt);
+}
+
+int Transcoder::filter_encode_write_frame(StreamContext& sc, AVFrame* input) {
+  int ret;
+
+  {
+    StageTimer timer(stats, STAGE_FILTER);
+    ret = av_buffersrc_add_frame_flags(sc.buffersrc_ctx, input, 0);
+  }
+
+  if (ret < 0) {
+    av_log(NULL, AV_LOG_ERROR, "Error while feeding the filter graph\n");
+    return ret;
+  }
+
+  // with several renditions the split fills all the sinks at once, so each
+  // one is emptied in turn
+  for (EncoderContext& ec : sc.encoders) {
+    while (true) {
+      {
+        StageTimer timer(stats, STAGE_FILTER);
+        ret = av_buffersink_get_frame(ec.buffersink_ctx, filt_frame);
+      }
+
+      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+        break;
+      if (ret < 0)
+        return ret;
+
+      filt_frame->pict_type = AV_PICTURE_TYPE_NONE;
+
+      ret = encode_write_frame(sc, ec, filt_frame);
+      av_frame_unref(filt_frame);
+
+      if (ret < 0)
+        return ret;
+    }
+  }
+
+  return 0;
+}
+
+int Transcoder::encode_write_frame(StreamContext& sc, EncoderContext& ec, AVFrame* input) {
+  AVCodecContext* enc_ctx = ec.enc_ctx;
+  OutputContext& output = outputs[ec.output];
+
+  if (input && input->pts != AV_NOPTS_VALUE) {
+    input->pts = av_rescale_q(input->pts, av_buffersink_get_time_base(ec.buffersink_ctx), enc_ctx->time_base);
+
+    // variable frame rate inputs may round two frames onto the same tick,
+    // which the encoders reject, so drop the late one like ffmpeg's vsync
+    if (enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+      if (ec.last_pts != AV_NOPTS_VALUE && input->pts <= ec.last_pts)
+        return 0;
+
+      ec.last_pts = input->pts;
+    }
+  }
+
+  if (input) {
+    stats.frames_encoded++;
+
+    // progress is measured on the first output, the others encode the same
+    // frames at another size
+    if (enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO && ec.output == 0)
+      stats.video_frames++;
+  }
+
+  int ret;
+
+  {
+    StageTimer timer(stats, STAGE_ENCODE);
+    ret = avcodec_send_frame(enc_ctx, input);
+  }
+
+  if (ret < 0)
+    return ret;
+
+  while (true) {
+    {
+      StageTimer timer(stats, STAGE_ENCODE);
+      ret = avcodec_receive_packet(enc_ctx, enc_packet);
+    }
+
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+      return 0;
+    if (ret < 0)
+      return ret;
+
+    enc_packet->stream_index = ec.out_index;
+    av_packet_rescale_ts(enc_packet, enc_ctx->time_base, output.fmt_ctx->streams[ec.out_index]->time_base);
+
+    if ((ret = write_packet(output, enc_packet)) < 0)
+      return ret;
+  }
+}
+
+EMSCRIPTEN_BINDINGS(ffmpeg) {
+  function("get_capabilities", &get_capabilities);
+
+  class_<InputSource>("InputSource")
+    .class_function("fromBuffer", &InputSource::from_buffer)
+    .class_function("fromReader", &InputSource::from_reader);
+
+  class_<OutputSink>("OutputSink")
+    .class_function("toBuffer", &OutputSink::to_buffer)
+    .class_function("toCallback", &OutputSink::to_callback)
+    .function("data", &OutputSink::data)
+    .function("bytesWritten", &OutputSink::bytes_written);
+
+  class_<Transcoder>("Transcoder")
+    .constructor<>()
+    .function("run", &Transcoder::run)
+    .function("runMany", &Transcoder::run_many)
+    .function("concat", &Transcoder::concat)
+    .function("copiesVideo", &Transcoder::copies_video)
+    .function("reset", &Transcoder::reset)
+    .function("cancel", &Transcoder::cancel)
+    .function("stats", &Transcoder::get_stats);
+
+  function("error_string", &error_string);
+  constant("AVERROR_EXIT", AVERROR_EXIT);
+  function("plan_segments", &plan_segments);
+  function("probe_input", &probe_input);
+  function("extract_thumbnails", &extract_thumbnails);
 }
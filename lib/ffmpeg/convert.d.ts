@@ -1,61 +1,264 @@
-interface EnumValue {
-  value: number
-}
-
 export interface ConvertOptions {
   verbose: boolean
   outputFormat: string
   videoEncoder: string
   audioEncoder: string
+  // `-key value` pairs for the encoders and the muxer, e.g. ['-b:v', '1M'].
+  // The job fails on other keys, like the CLI's -vf, -r or -an, and on options
+  // the output's encoders don't take. Options for copied streams are ignored.
   extraOptions?: string[]
+  // copy the streams already encoded with the requested codec instead of
+  // re-encoding them, an encoder named "copy" always does
+  streamCopy?: boolean
+  // range of the input to convert, in seconds
+  startTime?: number
+  endTime?: number
+  // called every `progressInterval` milliseconds (250 by default), returning
+  // true cancels the job
+  onProgress?: (progress: Progress) => boolean | void
+  progressInterval?: number
+  // bytes of heap the job may use, the input included. Jobs that would need
+  // more fail upfront, or as soon as they go over it.
+  memoryLimit?: number
+  // size the video is scaled to, a side left out follows the aspect ratio
+  width?: number
+  height?: number
+  // box the video is scaled down to fit in, keeping its aspect ratio
+  maxWidth?: number
+  maxHeight?: number
+  // x264 speed preset. "auto" tries the presets on the first second and picks
+  // the slowest one that finishes within `deadline`, scaling the video down
+  // when even ultrafast wouldn't
+  preset?: X264Preset | 'auto'
+  // seconds the auto preset aims to finish the job in, the length of the
+  // converted range by default
+  deadline?: number
+  tune?: X264Tune
+  // constant rate factor from 0 to 51, lower is better. Encoders other than
+  // libx264 get a matching fixed quantizer.
+  crf?: number
+  // maximum number of frames between keyframes
+  gop?: number
+}
+
+export type X264Preset =
+  | 'ultrafast'
+  | 'superfast'
+  | 'veryfast'
+  | 'faster'
+  | 'fast'
+  | 'medium'
+  | 'slow'
+  | 'slower'
+  | 'veryslow'
+
+export type X264Tune =
+  | 'film'
+  | 'animation'
+  | 'grain'
+  | 'stillimage'
+  | 'fastdecode'
+  | 'zerolatency'
+
+// One rendition of a `convertMany` job. Anything left out is taken from the
+// options of the job, whose range, progress and memory settings apply to all
+// of its outputs.
+export type OutputOptions = Partial<
+  Pick<
+    ConvertOptions,
+    | 'outputFormat'
+    | 'videoEncoder'
+    | 'audioEncoder'
+    | 'extraOptions'
+    | 'streamCopy'
+    | 'width'
+    | 'height'
+    | 'maxWidth'
+    | 'maxHeight'
+    | 'tune'
+    | 'crf'
+    | 'gop'
+  >
+> & { preset?: X264Preset }
+
+export interface MultiConvertOptions extends ConvertOptions {
+  outputs: OutputOptions[]
+}
+
+export interface Progress {
+  packets: number
+  frames: number
+  // seconds of the input processed so far, out of `duration`
+  time: number
+  duration: number
+  fps: number
+  bytes: number
 }
 
-interface Vector<T> {
-  get(index: number): T
-  size(): number
+export interface InputReader {
+  size: number
+  read(offset: number, length: number): Uint8Array
+}
+
+export interface ProbeOptions {
+  // bytes read to find the streams' parameters, 1 MiB by default
+  probeSize?: number
+  // where the keyframes of the main video stream come from, the demuxer's
+  // index by default, in presentation times like `scan` and the seeks of a
+  // conversion. Inputs without an index have no keyframes then.
+  keyframes?: 'index' | 'scan' | 'none'
+}
+
+export interface StreamInfo {
+  index: number
+  type: string
+  codec: string
+  codecLongName: string
+  profile: string
+  bitRate: number
+  duration: number
+  language: string
+  width?: number
+  height?: number
+  pixelFormat?: string
+  frameRate?: number
+  // clockwise, in degrees
+  rotation?: number
+  sampleRate?: number
+  channels?: number
+  channelLayout?: string
+  sampleFormat?: string
+}
+
+export interface ProbeInfo {
+  format: string
+  formatLongName: string
+  duration: number
+  startTime: number
+  bitRate: number
+  streams: StreamInfo[]
+  // streams a conversion would use
+  videoStream: number | null
+  audioStream: number | null
+  // in seconds
+  keyframes: number[]
+}
+
+export interface ThumbnailOptions {
+  // in seconds, one thumbnail is taken at each
+  times?: number[]
+  // without `times`, how many thumbnails to spread evenly over the input, 1 by
+  // default. Only one is taken when the input's duration is unknown
+  count?: number
+  // take the keyframe before each time instead, skipping every other frame
+  keyframesOnly?: boolean
+  // the thumbnails fit in this box keeping their aspect ratio, 320x320 by
+  // default, 0 leaves that side unbounded
+  width?: number
+  height?: number
+  // raw RGBA pixels by default
+  format?: 'rgba' | 'png' | 'jpeg'
+}
+
+export interface Thumbnail {
+  // in seconds, of the frame actually used
+  time: number
+  width: number
+  height: number
+  data: Uint8Array
+}
+
+// Counters of the last job. Times are the seconds spent in each stage of the
+// pipeline, the filter stage being where frames are scaled and converted.
+export interface JobStats {
+  demuxTime: number
+  decodeTime: number
+  filterTime: number
+  encodeTime: number
+  muxTime: number
+  packetsRead: number
+  packetsWritten: number
+  framesDecoded: number
+  framesEncoded: number
+  bytesRead: number
+  peakHeap: number
+  // what the auto preset picked
+  preset?: X264Preset
 }
 
 export interface Codec {
-  id: EnumValue
+  id: number
+  // AVMediaType, 0 for video and 1 for audio
+  type: number
   name: string
-  long_name: string
-  capabilities: number
-  type: EnumValue
+  longName: string
+  capabilities: {
+    drawHorizBand: boolean
+    dr1: boolean
+    truncated: boolean
+    delay: boolean
+    subFrames: boolean
+    experimental: boolean
+    intraOnly: boolean
+    lossless: boolean
+    hardware: boolean
+    hybrid: boolean
+  }
+  // empty when the encoder takes any
+  pixelFormats: string[]
+  sampleFormats: string[]
+  sampleRates: number[]
 }
 
 export interface Muxer {
   name: string
-  long_name: string
-  mime_type: string
-  extensions: string
-  video_codec?: EnumValue
-  audio_codec?: EnumValue
+  longName: string
+  mimeType: string
+  extensions: string[]
+  // codec ids, 0 when the muxer has no use for that kind of stream
+  videoCodec: number
+  audioCodec: number
+  // names of the encoders whose output the muxer can hold
+  encoders: string[]
+}
+
+export interface Capabilities {
+  // one encoder per codec
+  encoders: Codec[]
+  muxers: Muxer[]
 }
 
 export interface FFModule extends EmscriptenModule {
-  free_result(): void
-  convert(videoData: Uint8ClampedArray, opts: ConvertOptions): Uint8Array
-  list_encoders(): Vector<Codec>
-  list_muxers(): Vector<Muxer>
-  AV_CODEC_CAP_DRAW_HORIZ_BAND: number
-  AV_CODEC_CAP_DR1: number
-  AV_CODEC_CAP_TRUNCATED: number
-  AV_CODEC_CAP_DELAY: number
-  AV_CODEC_CAP_SMALL_LAST_FRAME: number
-  AV_CODEC_CAP_SUBFRAMES: number
-  AV_CODEC_CAP_EXPERIMENTAL: number
-  AV_CODEC_CAP_CHANNEL_CONF: number
-  AV_CODEC_CAP_FRAME_THREADS: number
-  AV_CODEC_CAP_SLICE_THREADS: number
-  AV_CODEC_CAP_PARAM_CHANGE: number
-  AV_CODEC_CAP_AUTO_THREADS: number
-  AV_CODEC_CAP_VARIABLE_FRAME_SIZE: number
-  AV_CODEC_CAP_AVOID_PROBING: number
-  AV_CODEC_CAP_INTRA_ONLY: number
-  AV_CODEC_CAP_LOSSLESS: number
-  AV_CODEC_CAP_HARDWARE: number
-  AV_CODEC_CAP_HYBRID: number
-  AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE: number
+  convert(
+    input: Uint8Array | InputReader,
+    opts: ConvertOptions,
+    onChunk?: (chunk: Uint8Array) => void
+  ): Uint8Array | null
+  convertMany(
+    input: Uint8Array | InputReader,
+    opts: MultiConvertOptions,
+    onChunk?: (chunk: Uint8Array, output: number) => void
+  ): Uint8Array[] | null
+  probe(input: Uint8Array | InputReader, opts?: ProbeOptions): ProbeInfo
+  thumbnails(
+    input: Uint8Array | InputReader,
+    opts?: ThumbnailOptions
+  ): Thumbnail[]
+  resolvePreset<T extends ConvertOptions>(
+    input: Uint8Array | InputReader,
+    opts: T
+  ): T & { preset?: X264Preset }
+  planSegments(input: Uint8Array | InputReader, count: number): number[]
+  concat(
+    segments: Uint8Array[],
+    cuts: number[],
+    opts: ConvertOptions,
+    onChunk?: (chunk: Uint8Array) => void
+  ): Uint8Array | null
+  cancel(): void
+  terminateThreads(): void
+  getStats(): JobStats | null
+  getCapabilities(): Capabilities
 }
 
 export default function(opts: Partial<EmscriptenModule>): FFModule
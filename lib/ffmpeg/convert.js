@@ -1,165 +0,0 @@
-
-var ffmpeg = (function() {
-  var _scriptDir = typeof document !== 'undefined' && document.currentScript ? document.currentScript.src : undefined;
-  return (
-function(ffmpeg) {
-  ffmpeg = ffmpeg || {};
-
-var f;f||(f=typeof ffmpeg !== 'undefined' ? ffmpeg : {});var aa=!1;
-f.convert=function(a,b){if(!aa){h("/data");var c=l("/data",{uc:!0});if(null===c.node)throw new r(44);if(!t(c.node.mode))throw new r(54);var d=ba(c.node,"x");if(d)throw new r(d);ca=c.path;aa=!0}c=da("input","w+");ea(c,a,0,a.length);fa(c);ha(["-hide_banner","-nostdin","-loglevel",b.verbose?"verbose":"quiet","-i","input","-vcodec",b.videoEncoder,"-acodec",b.audioEncoder,"-f",b.outputFormat].concat(b.extraOptions||[]).concat(["output"]));a=l("/data").node.Sb.output.Sb;Array.isArray(a)||a instanceof ArrayBuffer?
-a=new Uint8Array(a):a?a instanceof Uint8Array||(a=new Uint8Array(a.buffer)):a=new Uint8Array(0);return a};var ja={},ka;for(ka in f)f.hasOwnProperty(ka)&&(ja[ka]=f[ka]);var la=[],ma="./this.program";function na(a,b){throw b;}var oa=!1,pa=!1;oa="object"===typeof window;pa="function"===typeof importScripts;var u="",qa;
-if(oa||pa)pa?u=self.location.href:document.currentScript&&(u=document.currentScript.src),_scriptDir&&(u=_scriptDir),0!==u.indexOf("blob:")?u=u.substr(0,u.lastIndexOf("/")+1):u="",pa&&(qa=function(a){var b=new XMLHttpRequest;b.open("GET",a,!1);b.responseType="arraybuffer";b.send(null);return new Uint8Array(b.response)});var ra=f.print||console.log.bind(console),v=f.printErr||console.warn.bind(console);for(ka in ja)ja.hasOwnProperty(ka)&&(f[ka]=ja[ka]);ja=null;f.arguments&&(la=f.arguments);
-f.thisProgram&&(ma=f.thisProgram);f.quit&&(na=f.quit);function sa(a){var b=w[ta>>2];a=b+a+15&-16;a>ua()&&z();w[ta>>2]=a;return b}var va={"f64-rem":function(a,b){return a%b},"debugger":function(){}},wa;f.wasmBinary&&(wa=f.wasmBinary);var xa;f.noExitRuntime&&(xa=f.noExitRuntime);"object"!==typeof WebAssembly&&v("no native wasm support detected");var ya,za=new WebAssembly.Table({initial:7433,maximum:7433,element:"anyfunc"}),Aa=!1;
-function Ba(a){if("number"===typeof a){var b=!0;var c=a}else b=!1,c=a.length;var d=Ca(Math.max(c,1));if(b){a=d;0==(d&3)||z("Assertion failed: undefined");for(b=d+(c&-4);a<b;a+=4)w[a>>2]=0;for(b=d+c;a<b;)A[a++>>0]=0;return d}a.subarray||a.slice?B.set(a,d):B.set(new Uint8Array(a),d);return d}var Da="undefined"!==typeof TextDecoder?new TextDecoder("utf8"):void 0;
-function Ea(a,b,c){var d=b+c;for(c=b;a[c]&&!(c>=d);)++c;if(16<c-b&&a.subarray&&Da)return Da.decode(a.subarray(b,c));for(d="";b<c;){var e=a[b++];if(e&128){var g=a[b++]&63;if(192==(e&224))d+=String.fromCharCode((e&31)<<6|g);else{var k=a[b++]&63;e=224==(e&240)?(e&15)<<12|g<<6|k:(e&7)<<18|g<<12|k<<6|a[b++]&63;65536>e?d+=String.fromCharCode(e):(e-=65536,d+=String.fromCharCode(55296|e>>10,56320|e&1023))}}else d+=String.fromCharCode(e)}return d}function Fa(a){return a?Ea(B,a,void 0):""}
-function Ga(a,b,c,d){if(!(0<d))return 0;var e=c;d=c+d-1;for(var g=0;g<a.length;++g){var k=a.charCodeAt(g);if(55296<=k&&57343>=k){var m=a.charCodeAt(++g);k=65536+((k&1023)<<10)|m&1023}if(127>=k){if(c>=d)break;b[c++]=k}else{if(2047>=k){if(c+1>=d)break;b[c++]=192|k>>6}else{if(65535>=k){if(c+2>=d)break;b[c++]=224|k>>12}else{if(c+3>=d)break;b[c++]=240|k>>18;b[c++]=128|k>>12&63}b[c++]=128|k>>6&63}b[c++]=128|k&63}}b[c]=0;return c-e}
-function Ha(a){for(var b=0,c=0;c<a.length;++c){var d=a.charCodeAt(c);55296<=d&&57343>=d&&(d=65536+((d&1023)<<10)|a.charCodeAt(++c)&1023);127>=d?++b:b=2047>=d?b+2:65535>=d?b+3:b+4}return b}"undefined"!==typeof TextDecoder&&new TextDecoder("utf-16le");function Ia(a){var b=Ha(a)+1,c=Ja(b);Ga(a,A,c,b);return c}function Ka(a){0<a%65536&&(a+=65536-a%65536);return a}var La,A,B,Ma,Na,w,D,Oa,Pa;
-function Qa(a){La=a;f.HEAP8=A=new Int8Array(a);f.HEAP16=Ma=new Int16Array(a);f.HEAP32=w=new Int32Array(a);f.HEAPU8=B=new Uint8Array(a);f.HEAPU16=Na=new Uint16Array(a);f.HEAPU32=D=new Uint32Array(a);f.HEAPF32=Oa=new Float32Array(a);f.HEAPF64=Pa=new Float64Array(a)}var ta=3985008,Ra=f.TOTAL_MEMORY||16777216;f.wasmMemory?ya=f.wasmMemory:ya=new WebAssembly.Memory({initial:Ra/65536});ya&&(La=ya.buffer);Ra=La.byteLength;Qa(La);w[ta>>2]=9228080;
-function Sa(a){for(;0<a.length;){var b=a.shift();if("function"==typeof b)b();else{var c=b.od;"number"===typeof c?void 0===b.Qc?f.dynCall_v(c):f.dynCall_vi(c,b.Qc):c(void 0===b.Qc?null:b.Qc)}}}var Ta=[],Ua=[],Va=[],Wa=[],Xa=!1;function Ya(){var a=f.preRun.shift();Ta.unshift(a)}var Za=Math.abs,$a=Math.ceil,ab=Math.floor,bb=Math.min,cb=Math.trunc,db=0,eb=null,fb=null;f.preloadedImages={};f.preloadedAudios={};
-function z(a){if(f.onAbort)f.onAbort(a);ra(a);v(a);Aa=!0;throw"abort("+a+"). Build with -s ASSERTIONS=1 for more info.";}function gb(){var a=hb;return String.prototype.startsWith?a.startsWith("data:application/octet-stream;base64,"):0===a.indexOf("data:application/octet-stream;base64,")}var hb="convert.wasm";if(!gb()){var ib=hb;hb=f.locateFile?f.locateFile(ib,u):u+ib}
-function jb(){try{if(wa)return new Uint8Array(wa);if(qa)return qa(hb);throw"both async and sync fetching of the wasm failed";}catch(a){z(a)}}function kb(){return wa||!oa&&!pa||"function"!==typeof fetch?new Promise(function(a){a(jb())}):fetch(hb,{credentials:"same-origin"}).then(function(a){if(!a.ok)throw"failed to load wasm binary file at '"+hb+"'";return a.arrayBuffer()}).catch(function(){return jb()})}
-f.asm=function(){function a(a){f.asm=a.exports;db--;f.monitorRunDependencies&&f.monitorRunDependencies(db);0==db&&(null!==eb&&(clearInterval(eb),eb=null),fb&&(a=fb,fb=null,a()))}function b(b){a(b.instance)}function c(a){return kb().then(function(a){return WebAssembly.instantiate(a,d)}).then(a,function(a){v("failed to asynchronously prepare wasm: "+a);z(a)})}var d={env:lb,wasi_unstable:lb,global:{NaN:NaN,Infinity:Infinity},"global.Math":Math,asm2wasm:va};db++;f.monitorRunDependencies&&f.monitorRunDependencies(db);
-if(f.instantiateWasm)try{return f.instantiateWasm(d,a)}catch(e){return v("Module.instantiateWasm callback failed with error: "+e),!1}(function(){if(wa||"function"!==typeof WebAssembly.instantiateStreaming||gb()||"function"!==typeof fetch)return c(b);fetch(hb,{credentials:"same-origin"}).then(function(a){return WebAssembly.instantiateStreaming(a,d).then(b,function(a){v("wasm streaming compile failed: "+a);v("falling back to ArrayBuffer instantiation");c(b)})})})();return{}};var E,F;Ua.push({od:function(){mb()}});
-var G={};
-function nb(a){if(nb.ec){var b=w[a>>2];var c=w[b>>2]}else nb.ec=!0,G.USER="web_user",G.LOGNAME="web_user",G.PATH="/",G.PWD="/",G.HOME="/home/web_user",G.LANG=("object"===typeof navigator&&navigator.languages&&navigator.languages[0]||"C").replace("-","_")+".UTF-8",G._=ma,c=Xa?Ca(1024):sa(1024),b=Xa?Ca(256):sa(256),w[b>>2]=c,w[a>>2]=b;a=[];var d=0,e;for(e in G)if("string"===typeof G[e]){var g=e+"="+G[e];a.push(g);d+=g.length}if(1024<d)throw Error("Environment size exceeded TOTAL_ENV_SIZE!");for(e=0;e<
-a.length;e++){d=g=a[e];for(var k=c,m=0;m<d.length;++m)A[k++>>0]=d.charCodeAt(m);A[k>>0]=0;w[b+4*e>>2]=c;c+=g.length+1}w[b+4*a.length>>2]=0}function ob(a,b){for(var c=0,d=a.length-1;0<=d;d--){var e=a[d];"."===e?a.splice(d,1):".."===e?(a.splice(d,1),c++):c&&(a.splice(d,1),c--)}if(b)for(;c;c--)a.unshift("..");return a}function pb(a){var b="/"===a.charAt(0),c="/"===a.substr(-1);(a=ob(a.split("/").filter(function(a){return!!a}),!b).join("/"))||b||(a=".");a&&c&&(a+="/");return(b?"/":"")+a}
-function qb(a){var b=/^(\/?|)([\s\S]*?)((?:\.{1,2}|[^\/]+?|)(\.[^.\/]*|))(?:[\/]*)$/.exec(a).slice(1);a=b[0];b=b[1];if(!a&&!b)return".";b&&(b=b.substr(0,b.length-1));return a+b}function rb(a){if("/"===a)return"/";var b=a.lastIndexOf("/");return-1===b?a:a.substr(b+1)}function sb(){f.___errno_location&&(w[f.___errno_location()>>2]=28)}
-function vb(){for(var a="",b=!1,c=arguments.length-1;-1<=c&&!b;c--){b=0<=c?arguments[c]:ca;if("string"!==typeof b)throw new TypeError("Arguments to path.resolve must be strings");if(!b)return"";a=b+"/"+a;b="/"===b.charAt(0)}a=ob(a.split("/").filter(function(a){return!!a}),!b).join("/");return(b?"/":"")+a||"."}
-function wb(a,b){function c(a){for(var b=0;b<a.length&&""===a[b];b++);for(var c=a.length-1;0<=c&&""===a[c];c--);return b>c?[]:a.slice(b,c-b+1)}a=vb(a).substr(1);b=vb(b).substr(1);a=c(a.split("/"));b=c(b.split("/"));for(var d=Math.min(a.length,b.length),e=d,g=0;g<d;g++)if(a[g]!==b[g]){e=g;break}d=[];for(g=e;g<a.length;g++)d.push("..");d=d.concat(b.slice(e));return d.join("/")}var xb=[];function yb(a,b){xb[a]={input:[],ac:[],wc:b};zb(a,Ab)}
-var Ab={open:function(a){var b=xb[a.node.Ac];if(!b)throw new r(43);a.$b=b;a.seekable=!1},close:function(a){a.$b.wc.flush(a.$b)},flush:function(a){a.$b.wc.flush(a.$b)},read:function(a,b,c,d){if(!a.$b||!a.$b.wc.ad)throw new r(60);for(var e=0,g=0;g<d;g++){try{var k=a.$b.wc.ad(a.$b)}catch(m){throw new r(29);}if(void 0===k&&0===e)throw new r(6);if(null===k||void 0===k)break;e++;b[c+g]=k}e&&(a.node.timestamp=Date.now());return e},write:function(a,b,c,d){if(!a.$b||!a.$b.wc.Tc)throw new r(60);try{for(var e=
-0;e<d;e++)a.$b.wc.Tc(a.$b,b[c+e])}catch(g){throw new r(29);}d&&(a.node.timestamp=Date.now());return e}},Cb={ad:function(a){if(!a.input.length){var b=null;"undefined"!=typeof window&&"function"==typeof window.prompt?(b=window.prompt("Input: "),null!==b&&(b+="\n")):"function"==typeof readline&&(b=readline(),null!==b&&(b+="\n"));if(!b)return null;a.input=Bb(b,!0)}return a.input.shift()},Tc:function(a,b){null===b||10===b?(ra(Ea(a.ac,0)),a.ac=[]):0!=b&&a.ac.push(b)},flush:function(a){a.ac&&0<a.ac.length&&
-(ra(Ea(a.ac,0)),a.ac=[])}},Db={Tc:function(a,b){null===b||10===b?(v(Ea(a.ac,0)),a.ac=[]):0!=b&&a.ac.push(b)},flush:function(a){a.ac&&0<a.ac.length&&(v(Ea(a.ac,0)),a.ac=[])}},H={kc:null,fc:function(){return H.createNode(null,"/",16895,0)},createNode:function(a,b,c,d){if(24576===(c&61440)||4096===(c&61440))throw new r(63);H.kc||(H.kc={dir:{node:{jc:H.Tb.jc,lc:H.Tb.lc,yc:H.Tb.yc,Hc:H.Tb.Hc,Jc:H.Tb.Jc,Pc:H.Tb.Pc,Kc:H.Tb.Kc,Ic:H.Tb.Ic,Lc:H.Tb.Lc},stream:{rc:H.Ub.rc}},file:{node:{jc:H.Tb.jc,lc:H.Tb.lc},
-stream:{rc:H.Ub.rc,read:H.Ub.read,write:H.Ub.write,Wc:H.Ub.Wc,bd:H.Ub.bd,dd:H.Ub.dd}},link:{node:{jc:H.Tb.jc,lc:H.Tb.lc,Bc:H.Tb.Bc},stream:{}},Xc:{node:{jc:H.Tb.jc,lc:H.Tb.lc},stream:Eb}});c=Fb(a,b,c,d);t(c.mode)?(c.Tb=H.kc.dir.node,c.Ub=H.kc.dir.stream,c.Sb={}):32768===(c.mode&61440)?(c.Tb=H.kc.file.node,c.Ub=H.kc.file.stream,c.Yb=0,c.Sb=null):40960===(c.mode&61440)?(c.Tb=H.kc.link.node,c.Ub=H.kc.link.stream):8192===(c.mode&61440)&&(c.Tb=H.kc.Xc.node,c.Ub=H.kc.Xc.stream);c.timestamp=Date.now();a&&
-(a.Sb[b]=c);return c},Ld:function(a){if(a.Sb&&a.Sb.subarray){for(var b=[],c=0;c<a.Yb;++c)b.push(a.Sb[c]);return b}return a.Sb},Md:function(a){return a.Sb?a.Sb.subarray?a.Sb.subarray(0,a.Yb):new Uint8Array(a.Sb):new Uint8Array},Zc:function(a,b){var c=a.Sb?a.Sb.length:0;c>=b||(b=Math.max(b,c*(1048576>c?2:1.125)|0),0!=c&&(b=Math.max(b,256)),c=a.Sb,a.Sb=new Uint8Array(b),0<a.Yb&&a.Sb.set(c.subarray(0,a.Yb),0))},Cd:function(a,b){if(a.Yb!=b)if(0==b)a.Sb=null,a.Yb=0;else{if(!a.Sb||a.Sb.subarray){var c=a.Sb;
-a.Sb=new Uint8Array(new ArrayBuffer(b));c&&a.Sb.set(c.subarray(0,Math.min(b,a.Yb)))}else if(a.Sb||(a.Sb=[]),a.Sb.length>b)a.Sb.length=b;else for(;a.Sb.length<b;)a.Sb.push(0);a.Yb=b}},Tb:{jc:function(a){var b={};b.md=8192===(a.mode&61440)?a.id:1;b.Rc=a.id;b.mode=a.mode;b.wd=1;b.uid=0;b.rd=0;b.Ac=a.Ac;t(a.mode)?b.size=4096:32768===(a.mode&61440)?b.size=a.Yb:40960===(a.mode&61440)?b.size=a.link.length:b.size=0;b.gd=new Date(a.timestamp);b.vd=new Date(a.timestamp);b.ld=new Date(a.timestamp);b.hd=4096;
-b.jd=Math.ceil(b.size/b.hd);return b},lc:function(a,b){void 0!==b.mode&&(a.mode=b.mode);void 0!==b.timestamp&&(a.timestamp=b.timestamp);void 0!==b.size&&H.Cd(a,b.size)},yc:function(){throw Gb[44];},Hc:function(a,b,c,d){return H.createNode(a,b,c,d)},Jc:function(a,b,c){if(t(a.mode)){try{var d=I(b,c)}catch(g){}if(d)for(var e in d.Sb)throw new r(55);}delete a.parent.Sb[a.name];a.name=c;b.Sb[c]=a;a.parent=b},Pc:function(a,b){delete a.Sb[b]},Kc:function(a,b){var c=I(a,b),d;for(d in c.Sb)throw new r(55);
-delete a.Sb[b]},Ic:function(a){var b=[".",".."],c;for(c in a.Sb)a.Sb.hasOwnProperty(c)&&b.push(c);return b},Lc:function(a,b,c){a=H.createNode(a,b,41471,0);a.link=c;return a},Bc:function(a){if(40960!==(a.mode&61440))throw new r(28);return a.link}},Ub:{read:function(a,b,c,d,e){var g=a.node.Sb;if(e>=a.node.Yb)return 0;a=Math.min(a.node.Yb-e,d);if(8<a&&g.subarray)b.set(g.subarray(e,e+a),c);else for(d=0;d<a;d++)b[c+d]=g[e+d];return a},write:function(a,b,c,d,e,g){g=!1;if(!d)return 0;a=a.node;a.timestamp=
-Date.now();if(b.subarray&&(!a.Sb||a.Sb.subarray)){if(g)return a.Sb=b.subarray(c,c+d),a.Yb=d;if(0===a.Yb&&0===e)return a.Sb=new Uint8Array(b.subarray(c,c+d)),a.Yb=d;if(e+d<=a.Yb)return a.Sb.set(b.subarray(c,c+d),e),d}H.Zc(a,e+d);if(a.Sb.subarray&&b.subarray)a.Sb.set(b.subarray(c,c+d),e);else for(g=0;g<d;g++)a.Sb[e+g]=b[c+g];a.Yb=Math.max(a.Yb,e+d);return d},rc:function(a,b,c){1===c?b+=a.position:2===c&&32768===(a.node.mode&61440)&&(b+=a.node.Yb);if(0>b)throw new r(28);return b},Wc:function(a,b,c){H.Zc(a.node,
-b+c);a.node.Yb=Math.max(a.node.Yb,b+c)},bd:function(a,b,c,d,e,g,k){if(32768!==(a.node.mode&61440))throw new r(43);c=a.node.Sb;if(k&2||c.buffer!==b&&c.buffer!==b.buffer){if(0<e||e+d<a.node.Yb)c.subarray?c=c.subarray(e,e+d):c=Array.prototype.slice.call(c,e,e+d);a=!0;e=b.buffer==A.buffer;d=Ca(d);if(!d)throw new r(48);(e?A:b).set(c,d)}else a=!1,d=c.byteOffset;return{Wb:d,Kd:a}},dd:function(a,b,c,d,e){if(32768!==(a.node.mode&61440))throw new r(43);if(e&2)return 0;H.Ub.write(a,b,0,d,c,!1);return 0}}},Hb=
-null,Ib={},Jb=[],Kb=1,Lb=null,ca="/",Mb=!0,L={},r=null,Gb={};
-function l(a,b){a=vb(ca,a);b=b||{};if(!a)return{path:"",node:null};var c={$c:!0,Uc:0},d;for(d in c)void 0===b[d]&&(b[d]=c[d]);if(8<b.Uc)throw new r(32);a=ob(a.split("/").filter(function(a){return!!a}),!1);var e=Hb;c="/";for(d=0;d<a.length;d++){var g=d===a.length-1;if(g&&b.parent)break;e=I(e,a[d]);c=pb(c+"/"+a[d]);e.oc&&(!g||g&&b.$c)&&(e=e.oc.root);if(!g||b.uc)for(g=0;40960===(e.mode&61440);)if(e=Nb(c),c=vb(qb(c),e),e=l(c,{Uc:b.Uc}).node,40<g++)throw new r(32);}return{path:c,node:e}}
-function Ob(a){for(var b;;){if(a===a.parent)return a=a.fc.cd,b?"/"!==a[a.length-1]?a+"/"+b:a+b:a;b=b?a.name+"/"+b:a.name;a=a.parent}}function Pb(a,b){for(var c=0,d=0;d<b.length;d++)c=(c<<5)-c+b.charCodeAt(d)|0;return(a+c>>>0)%Lb.length}function Qb(a){var b=Pb(a.parent.id,a.name);a.vc=Lb[b];Lb[b]=a}function Rb(a){var b=Pb(a.parent.id,a.name);if(Lb[b]===a)Lb[b]=a.vc;else for(b=Lb[b];b;){if(b.vc===a){b.vc=a.vc;break}b=b.vc}}
-function I(a,b){var c;if(c=(c=ba(a,"x"))?c:a.Tb.yc?0:2)throw new r(c,a);for(c=Lb[Pb(a.id,b)];c;c=c.vc){var d=c.name;if(c.parent.id===a.id&&d===b)return c}return a.Tb.yc(a,b)}
-function Fb(a,b,c,d){Sb||(Sb=function(a,b,c,d){a||(a=this);this.parent=a;this.fc=a.fc;this.oc=null;this.id=Kb++;this.name=b;this.mode=c;this.Tb={};this.Ub={};this.Ac=d},Sb.prototype={},Object.defineProperties(Sb.prototype,{read:{get:function(){return 365===(this.mode&365)},set:function(a){a?this.mode|=365:this.mode&=-366}},write:{get:function(){return 146===(this.mode&146)},set:function(a){a?this.mode|=146:this.mode&=-147}}}));a=new Sb(a,b,c,d);Qb(a);return a}
-function t(a){return 16384===(a&61440)}var Tb={r:0,rs:1052672,"r+":2,w:577,wx:705,xw:705,"w+":578,"wx+":706,"xw+":706,a:1089,ax:1217,xa:1217,"a+":1090,"ax+":1218,"xa+":1218};function Ub(a){var b=["r","w","rw"][a&3];a&512&&(b+="w");return b}function ba(a,b){if(Mb)return 0;if(-1===b.indexOf("r")||a.mode&292){if(-1!==b.indexOf("w")&&!(a.mode&146)||-1!==b.indexOf("x")&&!(a.mode&73))return 2}else return 2;return 0}function Vb(a,b){try{return I(a,b),20}catch(c){}return ba(a,"wx")}
-function Wb(a,b,c){try{var d=I(a,b)}catch(e){return e.Xb}if(a=ba(a,"wx"))return a;if(c){if(!t(d.mode))return 54;if(d===d.parent||Ob(d)===ca)return 10}else if(t(d.mode))return 31;return 0}function Xb(a){var b=4096;for(a=a||0;a<=b;a++)if(!Jb[a])return a;throw new r(33);}
-function Yb(a,b){Zb||(Zb=function(){},Zb.prototype={},Object.defineProperties(Zb.prototype,{object:{get:function(){return this.node},set:function(a){this.node=a}}}));var c=new Zb,d;for(d in a)c[d]=a[d];a=c;b=Xb(b);a.mc=b;return Jb[b]=a}var Eb={open:function(a){a.Ub=Ib[a.node.Ac].Ub;a.Ub.open&&a.Ub.open(a)},rc:function(){throw new r(70);}};function zb(a,b){Ib[a]={Ub:b}}
-function $b(a,b){var c="/"===b,d=!b;if(c&&Hb)throw new r(10);if(!c&&!d){var e=l(b,{$c:!1});b=e.path;e=e.node;if(e.oc)throw new r(10);if(!t(e.mode))throw new r(54);}b={type:a,Pd:{},cd:b,ud:[]};a=a.fc(b);a.fc=b;b.root=a;c?Hb=a:e&&(e.oc=b,e.fc&&e.fc.ud.push(b))}function ac(a,b,c){var d=l(a,{parent:!0}).node;a=rb(a);if(!a||"."===a||".."===a)throw new r(28);var e=Vb(d,a);if(e)throw new r(e);if(!d.Tb.Hc)throw new r(63);return d.Tb.Hc(d,a,b,c)}function h(a){ac(a,16895,0)}
-function bc(a,b,c){"undefined"===typeof c&&(c=b,b=438);ac(a,b|8192,c)}function cc(a,b){if(!vb(a))throw new r(44);var c=l(b,{parent:!0}).node;if(!c)throw new r(44);b=rb(b);var d=Vb(c,b);if(d)throw new r(d);if(!c.Tb.Lc)throw new r(63);c.Tb.Lc(c,b,a)}function Nb(a){a=l(a).node;if(!a)throw new r(44);if(!a.Tb.Bc)throw new r(28);return vb(Ob(a.parent),a.Tb.Bc(a))}function dc(a,b){a=l(a,{uc:!b}).node;if(!a)throw new r(44);if(!a.Tb.jc)throw new r(63);return a.Tb.jc(a)}function ec(a){return dc(a,!0)}
-function da(a,b,c,d){if(""===a)throw new r(44);if("string"===typeof b){var e=Tb[b];if("undefined"===typeof e)throw Error("Unknown file open mode: "+b);b=e}c=b&64?("undefined"===typeof c?438:c)&4095|32768:0;if("object"===typeof a)var g=a;else{a=pb(a);try{g=l(a,{uc:!(b&131072)}).node}catch(m){}}e=!1;if(b&64)if(g){if(b&128)throw new r(20);}else g=ac(a,c,0),e=!0;if(!g)throw new r(44);8192===(g.mode&61440)&&(b&=-513);if(b&65536&&!t(g.mode))throw new r(54);if(!e&&(c=g?40960===(g.mode&61440)?32:t(g.mode)&&
-("r"!==Ub(b)||b&512)?31:ba(g,Ub(b)):44))throw new r(c);if(b&512){c=g;var k;"string"===typeof c?k=l(c,{uc:!0}).node:k=c;if(!k.Tb.lc)throw new r(63);if(t(k.mode))throw new r(31);if(32768!==(k.mode&61440))throw new r(28);if(c=ba(k,"w"))throw new r(c);k.Tb.lc(k,{size:0,timestamp:Date.now()})}b&=-641;d=Yb({node:g,path:Ob(g),flags:b,seekable:!0,position:0,Ub:g.Ub,Jd:[],error:!1},d);d.Ub.open&&d.Ub.open(d);!f.logReadFiles||b&1||(gc||(gc={}),a in gc||(gc[a]=1,console.log("FS.trackingDelegate error on read file: "+
-a)));try{L.onOpenFile&&(g=0,1!==(b&2097155)&&(g|=1),0!==(b&2097155)&&(g|=2),L.onOpenFile(a,g))}catch(m){console.log("FS.trackingDelegate['onOpenFile']('"+a+"', flags) threw an exception: "+m.message)}return d}function fa(a){if(null===a.mc)throw new r(8);a.qc&&(a.qc=null);try{a.Ub.close&&a.Ub.close(a)}catch(b){throw b;}finally{Jb[a.mc]=null}a.mc=null}
-function hc(a,b,c){if(null===a.mc)throw new r(8);if(!a.seekable||!a.Ub.rc)throw new r(70);if(0!=c&&1!=c&&2!=c)throw new r(28);a.position=a.Ub.rc(a,b,c);a.Jd=[];return a.position}
-function ic(a,b,c,d){var e=A;if(0>c||0>d)throw new r(28);if(null===a.mc)throw new r(8);if(1===(a.flags&2097155))throw new r(8);if(t(a.node.mode))throw new r(31);if(!a.Ub.read)throw new r(28);var g="undefined"!==typeof d;if(!g)d=a.position;else if(!a.seekable)throw new r(70);b=a.Ub.read(a,e,b,c,d);g||(a.position+=b);return b}
-function ea(a,b,c,d,e){if(0>d||0>e)throw new r(28);if(null===a.mc)throw new r(8);if(0===(a.flags&2097155))throw new r(8);if(t(a.node.mode))throw new r(31);if(!a.Ub.write)throw new r(28);a.flags&1024&&hc(a,0,2);var g="undefined"!==typeof e;if(!g)e=a.position;else if(!a.seekable)throw new r(70);b=a.Ub.write(a,b,c,d,e,void 0);g||(a.position+=b);try{if(a.path&&L.onWriteToFile)L.onWriteToFile(a.path)}catch(k){console.log("FS.trackingDelegate['onWriteToFile']('"+a.path+"') threw an exception: "+k.message)}return b}
-function jc(){r||(r=function(a,b){this.node=b;this.Dd=function(a){this.Xb=a};this.Dd(a);this.message="FS error"},r.prototype=Error(),r.prototype.constructor=r,[44].forEach(function(a){Gb[a]=new r(a);Gb[a].stack="<generic error, no stack>"}))}var kc;function lc(a,b){var c=0;a&&(c|=365);b&&(c|=146);return c}
-function mc(a,b,c){a=pb("/dev/"+a);var d=lc(!!b,!!c);nc||(nc=64);var e=nc++<<8|0;zb(e,{open:function(a){a.seekable=!1},close:function(){c&&c.buffer&&c.buffer.length&&c(10)},read:function(a,c,d,e){for(var g=0,k=0;k<e;k++){try{var m=b()}catch(C){throw new r(29);}if(void 0===m&&0===g)throw new r(6);if(null===m||void 0===m)break;g++;c[d+k]=m}g&&(a.node.timestamp=Date.now());return g},write:function(a,b,d,e){for(var g=0;g<e;g++)try{c(b[d+g])}catch(p){throw new r(29);}e&&(a.node.timestamp=Date.now());return g}});
-bc(a,d,e)}var nc,M={},Sb,Zb,gc;
-function oc(a,b,c){try{var d=a(b)}catch(e){if(e&&e.node&&pb(b)!==pb(Ob(e.node)))return-54;throw e;}w[c>>2]=d.md;w[c+4>>2]=0;w[c+8>>2]=d.Rc;w[c+12>>2]=d.mode;w[c+16>>2]=d.wd;w[c+20>>2]=d.uid;w[c+24>>2]=d.rd;w[c+28>>2]=d.Ac;w[c+32>>2]=0;F=[d.size>>>0,(E=d.size,1<=+Za(E)?0<E?(bb(+ab(E/4294967296),4294967295)|0)>>>0:~~+$a((E-+(~~E>>>0))/4294967296)>>>0:0)];w[c+40>>2]=F[0];w[c+44>>2]=F[1];w[c+48>>2]=4096;w[c+52>>2]=d.jd;w[c+56>>2]=d.gd.getTime()/1E3|0;w[c+60>>2]=0;w[c+64>>2]=d.vd.getTime()/1E3|0;w[c+68>>
-2]=0;w[c+72>>2]=d.ld.getTime()/1E3|0;w[c+76>>2]=0;F=[d.Rc>>>0,(E=d.Rc,1<=+Za(E)?0<E?(bb(+ab(E/4294967296),4294967295)|0)>>>0:~~+$a((E-+(~~E>>>0))/4294967296)>>>0:0)];w[c+80>>2]=F[0];w[c+84>>2]=F[1];return 0}var N=0;function P(){N+=4;return w[N-4>>2]}function pc(){return Fa(P())}function Q(a){void 0===a&&(a=P());a=Jb[a];if(!a)throw new r(8);return a}function qc(a){try{var b=Q(a);fa(b);return 0}catch(c){return"undefined"!==typeof M&&c instanceof r||z(c),c.Xb}}
-function rc(a,b){try{var c=Q(a);A[b>>0]=c.$b?2:t(c.mode)?3:40960===(c.mode&61440)?7:4;return 0}catch(d){return"undefined"!==typeof M&&d instanceof r||z(d),d.Xb}}function sc(a,b,c,d){try{a:{for(var e=Q(a),g=a=0;g<c;g++){var k=w[b+(8*g+4)>>2],m=ic(e,w[b+8*g>>2],k,void 0);if(0>m){var q=-1;break a}a+=m;if(m<k)break}q=a}w[d>>2]=q;return 0}catch(n){return"undefined"!==typeof M&&n instanceof r||z(n),n.Xb}}
-function tc(a,b,c,d,e){try{var g=Q(a);a=4294967296*c+(b>>>0);if(-9007199254740992>=a||9007199254740992<=a)return-61;hc(g,a,d);F=[g.position>>>0,(E=g.position,1<=+Za(E)?0<E?(bb(+ab(E/4294967296),4294967295)|0)>>>0:~~+$a((E-+(~~E>>>0))/4294967296)>>>0:0)];w[e>>2]=F[0];w[e+4>>2]=F[1];g.qc&&0===a&&0===d&&(g.qc=null);return 0}catch(k){return"undefined"!==typeof M&&k instanceof r||z(k),k.Xb}}
-function uc(a,b,c,d){try{a:{for(var e=Q(a),g=a=0;g<c;g++){var k=ea(e,A,w[b+8*g>>2],w[b+(8*g+4)>>2],void 0);if(0>k){var m=-1;break a}a+=k}m=a}w[d>>2]=m;return 0}catch(q){return"undefined"!==typeof M&&q instanceof r||z(q),q.Xb}}function vc(a){switch(a){case 1:return 0;case 2:return 1;case 4:return 2;case 8:return 3;default:throw new TypeError("Unknown type size: "+a);}}var wc=void 0;function R(a){for(var b="";B[a];)b+=wc[B[a++]];return b}var xc={},yc={},zc={};
-function Ac(a){if(void 0===a)return"_unknown";a=a.replace(/[^a-zA-Z0-9_]/g,"$");var b=a.charCodeAt(0);return 48<=b&&57>=b?"_"+a:a}function Bc(a,b){a=Ac(a);return(new Function("body","return function "+a+'() {\n    "use strict";    return body.apply(this, arguments);\n};\n'))(b)}
-function Cc(a){var b=Error,c=Bc(a,function(b){this.name=a;this.message=b;b=Error(b).stack;void 0!==b&&(this.stack=this.toString()+"\n"+b.replace(/^Error(:[^\n]*)?\n/,""))});c.prototype=Object.create(b.prototype);c.prototype.constructor=c;c.prototype.toString=function(){return void 0===this.message?this.name:this.name+": "+this.message};return c}var Dc=void 0;function S(a){throw new Dc(a);}var Ec=void 0;function Fc(a){throw new Ec(a);}
-function T(a,b,c){function d(b){b=c(b);b.length!==a.length&&Fc("Mismatched type converter count");for(var d=0;d<a.length;++d)U(a[d],b[d])}a.forEach(function(a){zc[a]=b});var e=Array(b.length),g=[],k=0;b.forEach(function(a,b){yc.hasOwnProperty(a)?e[b]=yc[a]:(g.push(a),xc.hasOwnProperty(a)||(xc[a]=[]),xc[a].push(function(){e[b]=yc[a];++k;k===g.length&&d(e)}))});0===g.length&&d(e)}
-function U(a,b,c){c=c||{};if(!("argPackAdvance"in b))throw new TypeError("registerType registeredInstance requires argPackAdvance");var d=b.name;a||S('type "'+d+'" must have a positive integer typeid pointer');if(yc.hasOwnProperty(a)){if(c.sd)return;S("Cannot register type '"+d+"' twice")}yc[a]=b;delete zc[a];xc.hasOwnProperty(a)&&(b=xc[a],delete xc[a],b.forEach(function(a){a()}))}function Gc(a){return{count:a.count,tc:a.tc,zc:a.zc,Wb:a.Wb,Zb:a.Zb,dc:a.dc,gc:a.gc}}
-function Hc(a){S(a.Rb.Zb.Vb.name+" instance already deleted")}var Ic=!1;function Jc(){}function Kc(a){--a.count.value;0===a.count.value&&(a.dc?a.gc.sc(a.dc):a.Zb.Vb.sc(a.Wb))}
-function Lc(a){if("undefined"===typeof FinalizationGroup)return Lc=function(a){return a},a;Ic=new FinalizationGroup(function(a){for(var b=a.next();!b.done;b=a.next())b=b.value,b.Wb?Kc(b):console.warn("object already deleted: "+b.Wb)});Lc=function(a){Ic.register(a,a.Rb,a.Rb);return a};Jc=function(a){Ic.unregister(a.Rb)};return Lc(a)}var Mc=void 0,Nc=[];function Oc(){for(;Nc.length;){var a=Nc.pop();a.Rb.tc=!1;a["delete"]()}}function Pc(){}var Qc={};
-function Rc(a,b,c){if(void 0===a[b].bc){var d=a[b];a[b]=function(){a[b].bc.hasOwnProperty(arguments.length)||S("Function '"+c+"' called with an invalid number of arguments ("+arguments.length+") - expects one of ("+a[b].bc+")!");return a[b].bc[arguments.length].apply(this,arguments)};a[b].bc=[];a[b].bc[d.Ec]=d}}
-function Sc(a,b,c){f.hasOwnProperty(a)?((void 0===c||void 0!==f[a].bc&&void 0!==f[a].bc[c])&&S("Cannot register public name '"+a+"' twice"),Rc(f,a,a),f.hasOwnProperty(c)&&S("Cannot register multiple overloads of a function with the same number of arguments ("+c+")!"),f[a].bc[c]=b):(f[a]=b,void 0!==c&&(f[a].Od=c))}function Tc(a,b,c,d,e,g,k,m){this.name=a;this.constructor=b;this.nc=c;this.sc=d;this.hc=e;this.pd=g;this.Dc=k;this.nd=m;this.zd=[]}
-function Uc(a,b,c){for(;b!==c;)b.Dc||S("Expected null or instance of "+c.name+", got an instance of "+b.name),a=b.Dc(a),b=b.hc;return a}function Vc(a,b){if(null===b)return this.Sc&&S("null is not a valid "+this.name),0;b.Rb||S('Cannot pass "'+Wc(b)+'" as a '+this.name);b.Rb.Wb||S("Cannot pass deleted object as a pointer of type "+this.name);return Uc(b.Rb.Wb,b.Rb.Zb.Vb,this.Vb)}
-function Xc(a,b){if(null===b){this.Sc&&S("null is not a valid "+this.name);if(this.Gc){var c=this.Ad();null!==a&&a.push(this.sc,c);return c}return 0}b.Rb||S('Cannot pass "'+Wc(b)+'" as a '+this.name);b.Rb.Wb||S("Cannot pass deleted object as a pointer of type "+this.name);!this.Fc&&b.Rb.Zb.Fc&&S("Cannot convert argument of type "+(b.Rb.gc?b.Rb.gc.name:b.Rb.Zb.name)+" to parameter type "+this.name);c=Uc(b.Rb.Wb,b.Rb.Zb.Vb,this.Vb);if(this.Gc)switch(void 0===b.Rb.dc&&S("Passing raw pointer to smart pointer is illegal"),
-this.Ed){case 0:b.Rb.gc===this?c=b.Rb.dc:S("Cannot convert argument of type "+(b.Rb.gc?b.Rb.gc.name:b.Rb.Zb.name)+" to parameter type "+this.name);break;case 1:c=b.Rb.dc;break;case 2:if(b.Rb.gc===this)c=b.Rb.dc;else{var d=b.clone();c=this.Bd(c,Yc(function(){d["delete"]()}));null!==a&&a.push(this.sc,c)}break;default:S("Unsupporting sharing policy")}return c}
-function Zc(a,b){if(null===b)return this.Sc&&S("null is not a valid "+this.name),0;b.Rb||S('Cannot pass "'+Wc(b)+'" as a '+this.name);b.Rb.Wb||S("Cannot pass deleted object as a pointer of type "+this.name);b.Rb.Zb.Fc&&S("Cannot convert argument of type "+b.Rb.Zb.name+" to parameter type "+this.name);return Uc(b.Rb.Wb,b.Rb.Zb.Vb,this.Vb)}function $c(a){return this.fromWireType(D[a>>2])}function ad(a,b,c){if(b===c)return a;if(void 0===c.hc)return null;a=ad(a,b,c.hc);return null===a?null:c.nd(a)}
-var bd={};function cd(a,b){for(void 0===b&&S("ptr should not be undefined");a.hc;)b=a.Dc(b),a=a.hc;return bd[b]}function dd(a,b){b.Zb&&b.Wb||Fc("makeClassHandle requires ptr and ptrType");!!b.gc!==!!b.dc&&Fc("Both smartPtrType and smartPtr must be specified");b.count={value:1};return Lc(Object.create(a,{Rb:{value:b}}))}
-function V(a,b,c,d){this.name=a;this.Vb=b;this.Sc=c;this.Fc=d;this.Gc=!1;this.sc=this.Bd=this.Ad=this.ed=this.Ed=this.xd=void 0;void 0!==b.hc?this.toWireType=Xc:(this.toWireType=d?Vc:Zc,this.ic=null)}function ed(a,b,c){f.hasOwnProperty(a)||Fc("Replacing nonexistant public symbol");void 0!==f[a].bc&&void 0!==c?f[a].bc[c]=b:(f[a]=b,f[a].Ec=c)}
-function W(a,b){a=R(a);if(void 0!==f["FUNCTION_TABLE_"+a])var c=f["FUNCTION_TABLE_"+a][b];else if("undefined"!==typeof FUNCTION_TABLE)c=FUNCTION_TABLE[b];else{c=f["dynCall_"+a];void 0===c&&(c=f["dynCall_"+a.replace(/f/g,"d")],void 0===c&&S("No dynCall invoker for signature: "+a));for(var d=[],e=1;e<a.length;++e)d.push("a"+e);e="return function "+("dynCall_"+a+"_"+b)+"("+d.join(", ")+") {\n";e+="    return dynCall(rawFunction"+(d.length?", ":"")+d.join(", ")+");\n";c=(new Function("dynCall","rawFunction",
-e+"};\n"))(c,b)}"function"!==typeof c&&S("unknown function pointer with signature "+a+": "+b);return c}var fd=void 0;function gd(a){a=hd(a);var b=R(a);X(a);return b}function id(a,b){function c(a){e[a]||yc[a]||(zc[a]?zc[a].forEach(c):(d.push(a),e[a]=!0))}var d=[],e={};b.forEach(c);throw new fd(a+": "+d.map(gd).join([", "]));}function jd(a,b){for(var c=[],d=0;d<a;d++)c.push(w[(b>>2)+d]);return c}function kd(a){for(;a.length;){var b=a.pop();a.pop()(b)}}
-function ld(a){var b=Function;if(!(b instanceof Function))throw new TypeError("new_ called with constructor type "+typeof b+" which is not a function");var c=Bc(b.name||"unknownFunctionName",function(){});c.prototype=b.prototype;c=new c;a=b.apply(c,a);return a instanceof Object?a:c}
-function md(a,b,c,d,e){var g=b.length;2>g&&S("argTypes array size mismatch! Must at least get return value and 'this' types!");var k=null!==b[1]&&null!==c,m=!1;for(c=1;c<b.length;++c)if(null!==b[c]&&void 0===b[c].ic){m=!0;break}var q="void"!==b[0].name,n="",p="";for(c=0;c<g-2;++c)n+=(0!==c?", ":"")+"arg"+c,p+=(0!==c?", ":"")+"arg"+c+"Wired";a="return function "+Ac(a)+"("+n+") {\nif (arguments.length !== "+(g-2)+") {\nthrowBindingError('function "+a+" called with ' + arguments.length + ' arguments, expected "+
-(g-2)+" args!');\n}\n";m&&(a+="var destructors = [];\n");var x=m?"destructors":"null";n="throwBindingError invoker fn runDestructors retType classParam".split(" ");d=[S,d,e,kd,b[0],b[1]];k&&(a+="var thisWired = classParam.toWireType("+x+", this);\n");for(c=0;c<g-2;++c)a+="var arg"+c+"Wired = argType"+c+".toWireType("+x+", arg"+c+"); // "+b[c+2].name+"\n",n.push("argType"+c),d.push(b[c+2]);k&&(p="thisWired"+(0<p.length?", ":"")+p);a+=(q?"var rv = ":"")+"invoker(fn"+(0<p.length?", ":"")+p+");\n";if(m)a+=
-"runDestructors(destructors);\n";else for(c=k?1:2;c<b.length;++c)g=1===c?"thisWired":"arg"+(c-2)+"Wired",null!==b[c].ic&&(a+=g+"_dtor("+g+"); // "+b[c].name+"\n",n.push(g+"_dtor"),d.push(b[c].ic));q&&(a+="var ret = retType.fromWireType(rv);\nreturn ret;\n");n.push(a+"}\n");return ld(n).apply(null,d)}
-function nd(a,b,c){a instanceof Object||S(c+' with invalid "this": '+a);a instanceof b.Vb.constructor||S(c+' incompatible with "this" of type '+a.constructor.name);a.Rb.Wb||S("cannot call emscripten binding method "+c+" on deleted object");return Uc(a.Rb.Wb,a.Rb.Zb.Vb,b.Vb)}var od=[],Y=[{},{value:void 0},{value:null},{value:!0},{value:!1}];function pd(a){4<a&&0===--Y[a].Vc&&(Y[a]=void 0,od.push(a))}
-function Yc(a){switch(a){case void 0:return 1;case null:return 2;case !0:return 3;case !1:return 4;default:var b=od.length?od.pop():Y.length;Y[b]={Vc:1,value:a};return b}}function qd(a,b,c){switch(b){case 0:return function(a){return this.fromWireType((c?A:B)[a])};case 1:return function(a){return this.fromWireType((c?Ma:Na)[a>>1])};case 2:return function(a){return this.fromWireType((c?w:D)[a>>2])};default:throw new TypeError("Unknown integer type: "+a);}}
-function rd(a,b){var c=yc[a];void 0===c&&S(b+" has unknown type "+gd(a));return c}function Wc(a){if(null===a)return"null";var b=typeof a;return"object"===b||"array"===b||"function"===b?a.toString():""+a}function sd(a,b){switch(b){case 2:return function(a){return this.fromWireType(Oa[a>>2])};case 3:return function(a){return this.fromWireType(Pa[a>>3])};default:throw new TypeError("Unknown float type: "+a);}}
-function td(a,b,c){switch(b){case 0:return c?function(a){return A[a]}:function(a){return B[a]};case 1:return c?function(a){return Ma[a>>1]}:function(a){return Na[a>>1]};case 2:return c?function(a){return w[a>>2]}:function(a){return D[a>>2]};default:throw new TypeError("Unknown integer type: "+a);}}function ud(){void 0===ud.start&&(ud.start=Date.now());return 1E3*(Date.now()-ud.start)|0}function vd(){z()}function ua(){return A.length}
-function wd(a){if(0===a)return 0;a=Fa(a);if(!G.hasOwnProperty(a))return 0;wd.ec&&X(wd.ec);a=G[a];var b=Ha(a)+1,c=Ca(b);c&&Ga(a,A,c,b);wd.ec=c;return wd.ec}Ga("GMT",B,3985088,4);
-function xd(a,b){a=new Date(1E3*w[a>>2]);w[b>>2]=a.getUTCSeconds();w[b+4>>2]=a.getUTCMinutes();w[b+8>>2]=a.getUTCHours();w[b+12>>2]=a.getUTCDate();w[b+16>>2]=a.getUTCMonth();w[b+20>>2]=a.getUTCFullYear()-1900;w[b+24>>2]=a.getUTCDay();w[b+36>>2]=0;w[b+32>>2]=0;w[b+28>>2]=(a.getTime()-Date.UTC(a.getUTCFullYear(),0,1,0,0,0,0))/864E5|0;w[b+40>>2]=3985088;return b}function yd(a){return Math.pow(2,a)}function zd(a){return Math.log(a)/Math.LN10}function Ad(a){return Math.log(a)/Math.LN2}
-function Bd(){Bd.ec||(Bd.ec=[]);Bd.ec.push(Cd());return Bd.ec.length-1}
-function Dd(){function a(a){return(a=a.toTimeString().match(/\(([A-Za-z ]+)\)$/))?a[1]:"GMT"}if(!Ed){Ed=!0;w[Fd()>>2]=60*(new Date).getTimezoneOffset();var b=(new Date).getFullYear(),c=new Date(b,0,1);b=new Date(b,6,1);w[Gd()>>2]=Number(c.getTimezoneOffset()!=b.getTimezoneOffset());var d=a(c),e=a(b);d=Ba(Bb(d));e=Ba(Bb(e));b.getTimezoneOffset()<c.getTimezoneOffset()?(w[Hd()>>2]=d,w[Hd()+4>>2]=e):(w[Hd()>>2]=e,w[Hd()+4>>2]=d)}}var Ed;
-function Id(a,b){Dd();a=new Date(1E3*w[a>>2]);w[b>>2]=a.getSeconds();w[b+4>>2]=a.getMinutes();w[b+8>>2]=a.getHours();w[b+12>>2]=a.getDate();w[b+16>>2]=a.getMonth();w[b+20>>2]=a.getFullYear()-1900;w[b+24>>2]=a.getDay();var c=new Date(a.getFullYear(),0,1);w[b+28>>2]=(a.getTime()-c.getTime())/864E5|0;w[b+36>>2]=-(60*a.getTimezoneOffset());var d=(new Date(a.getFullYear(),6,1)).getTimezoneOffset();c=c.getTimezoneOffset();a=(d!=c&&a.getTimezoneOffset()==Math.min(c,d))|0;w[b+32>>2]=a;a=w[Hd()+(a?4:0)>>2];
-w[b+40>>2]=a;return b}function Jd(a){return 0===a%4&&(0!==a%100||0===a%400)}function Kd(a,b){for(var c=0,d=0;d<=b;c+=a[d++]);return c}var Ld=[31,29,31,30,31,30,31,31,30,31,30,31],Md=[31,28,31,30,31,30,31,31,30,31,30,31];function Nd(a,b){for(a=new Date(a.getTime());0<b;){var c=a.getMonth(),d=(Jd(a.getFullYear())?Ld:Md)[c];if(b>d-a.getDate())b-=d-a.getDate()+1,a.setDate(1),11>c?a.setMonth(c+1):(a.setMonth(0),a.setFullYear(a.getFullYear()+1));else{a.setDate(a.getDate()+b);break}}return a}jc();Lb=Array(4096);
-$b(H,"/");h("/tmp");h("/home");h("/home/web_user");(function(){h("/dev");zb(259,{read:function(){return 0},write:function(a,b,e,g){return g}});bc("/dev/null",259);yb(1280,Cb);yb(1536,Db);bc("/dev/tty",1280);bc("/dev/tty1",1536);if("object"===typeof crypto&&"function"===typeof crypto.getRandomValues){var a=new Uint8Array(1);var b=function(){crypto.getRandomValues(a);return a[0]}}b||(b=function(){z("random_device")});mc("random",b);mc("urandom",b);h("/dev/shm");h("/dev/shm/tmp")})();h("/proc");h("/proc/self");
-h("/proc/self/fd");$b({fc:function(){var a=Fb("/proc/self","fd",16895,73);a.Tb={yc:function(a,c){var b=Jb[+c];if(!b)throw new r(8);a={parent:null,fc:{cd:"fake"},Tb:{Bc:function(){return b.path}}};return a.parent=a}};return a}},"/proc/self/fd");for(var Od=Array(256),Pd=0;256>Pd;++Pd)Od[Pd]=String.fromCharCode(Pd);wc=Od;Dc=f.BindingError=Cc("BindingError");Ec=f.InternalError=Cc("InternalError");
-Pc.prototype.isAliasOf=function(a){if(!(this instanceof Pc&&a instanceof Pc))return!1;var b=this.Rb.Zb.Vb,c=this.Rb.Wb,d=a.Rb.Zb.Vb;for(a=a.Rb.Wb;b.hc;)c=b.Dc(c),b=b.hc;for(;d.hc;)a=d.Dc(a),d=d.hc;return b===d&&c===a};Pc.prototype.clone=function(){this.Rb.Wb||Hc(this);if(this.Rb.zc)return this.Rb.count.value+=1,this;var a=Lc(Object.create(Object.getPrototypeOf(this),{Rb:{value:Gc(this.Rb)}}));a.Rb.count.value+=1;a.Rb.tc=!1;return a};
-Pc.prototype["delete"]=function(){this.Rb.Wb||Hc(this);this.Rb.tc&&!this.Rb.zc&&S("Object already scheduled for deletion");Jc(this);Kc(this.Rb);this.Rb.zc||(this.Rb.dc=void 0,this.Rb.Wb=void 0)};Pc.prototype.isDeleted=function(){return!this.Rb.Wb};Pc.prototype.deleteLater=function(){this.Rb.Wb||Hc(this);this.Rb.tc&&!this.Rb.zc&&S("Object already scheduled for deletion");Nc.push(this);1===Nc.length&&Mc&&Mc(Oc);this.Rb.tc=!0;return this};V.prototype.qd=function(a){this.ed&&(a=this.ed(a));return a};
-V.prototype.Yc=function(a){this.sc&&this.sc(a)};V.prototype.argPackAdvance=8;V.prototype.readValueFromPointer=$c;V.prototype.deleteObject=function(a){if(null!==a)a["delete"]()};
-V.prototype.fromWireType=function(a){function b(){return this.Gc?dd(this.Vb.nc,{Zb:this.xd,Wb:c,gc:this,dc:a}):dd(this.Vb.nc,{Zb:this,Wb:a})}var c=this.qd(a);if(!c)return this.Yc(a),null;var d=cd(this.Vb,c);if(void 0!==d){if(0===d.Rb.count.value)return d.Rb.Wb=c,d.Rb.dc=a,d.clone();d=d.clone();this.Yc(a);return d}d=this.Vb.pd(c);d=Qc[d];if(!d)return b.call(this);d=this.Fc?d.kd:d.pointerType;var e=ad(c,this.Vb,d.Vb);return null===e?b.call(this):this.Gc?dd(d.Vb.nc,{Zb:d,Wb:e,gc:this,dc:a}):dd(d.Vb.nc,
-{Zb:d,Wb:e})};f.getInheritedInstanceCount=function(){return Object.keys(bd).length};f.getLiveInheritedInstances=function(){var a=[],b;for(b in bd)bd.hasOwnProperty(b)&&a.push(bd[b]);return a};f.flushPendingDeletes=Oc;f.setDelayFunction=function(a){Mc=a;Nc.length&&Mc&&Mc(Oc)};fd=f.UnboundTypeError=Cc("UnboundTypeError");f.count_emval_handles=function(){for(var a=0,b=5;b<Y.length;++b)void 0!==Y[b]&&++a;return a};f.get_first_emval=function(){for(var a=5;a<Y.length;++a)if(void 0!==Y[a])return Y[a];return null};
-"undefined"!==typeof dateNow?vd=dateNow:"object"===typeof performance&&performance&&"function"===typeof performance.now?vd=function(){return performance.now()}:vd=Date.now;function Bb(a,b){var c=Array(Ha(a)+1);a=Ga(a,c,0,c.length);b&&(c.length=a);return c}
-var lb={b:function(a,b,c,d){z("Assertion failed: "+Fa(a)+", at: "+[b?Fa(b):"unknown filename",c,d?Fa(d):"unknown function"])},pa:nb,N:function(a){return Ca(a)},G:function(a){"uncaught_exception"in Qd?Qd.fd++:Qd.fd=1;throw a;},D:function(){},Y:function(a,b){N=b;try{var c=pc(),d=l(c,{parent:!0}).node,e=rb(c),g=I(d,e),k=Wb(d,e,!1);if(k)throw new r(k);if(!d.Tb.Pc)throw new r(63);if(g.oc)throw new r(10);try{L.willDeletePath&&L.willDeletePath(c)}catch(m){console.log("FS.trackingDelegate['willDeletePath']('"+
-c+"') threw an exception: "+m.message)}d.Tb.Pc(d,e);Rb(g);try{if(L.onDeletePath)L.onDeletePath(c)}catch(m){console.log("FS.trackingDelegate['onDeletePath']('"+c+"') threw an exception: "+m.message)}return 0}catch(m){return"undefined"!==typeof M&&m instanceof r||z(m),-m.Xb}},U:function(a,b){N=b;try{var c=P(),d=P(),e=P(),g=P();P();a=0;for(var k=d?w[d>>2]:0,m=d?w[d+4>>2]:0,q=e?w[e>>2]:0,n=e?w[e+4>>2]:0,p=g?w[g>>2]:0,x=g?w[g+4>>2]:0,C=b=0,y=0,ia=0,Z=0,J=0,Xd=(d?w[d>>2]:0)|(e?w[e>>2]:0)|(g?w[g>>2]:0),
-Yd=(d?w[d+4>>2]:0)|(e?w[e+4>>2]:0)|(g?w[g+4>>2]:0),O=0;O<c;O++){var K=1<<O%32;if(32>O?Xd&K:Yd&K){var tb=Jb[O];if(!tb)throw new r(8);var ub=5;tb.Ub.yd&&(ub=tb.Ub.yd(tb));ub&1&&(32>O?k&K:m&K)&&(32>O?b|=K:C|=K,a++);ub&4&&(32>O?q&K:n&K)&&(32>O?y|=K:ia|=K,a++);ub&2&&(32>O?p&K:x&K)&&(32>O?Z|=K:J|=K,a++)}}d&&(w[d>>2]=b,w[d+4>>2]=C);e&&(w[e>>2]=y,w[e+4>>2]=ia);g&&(w[g>>2]=Z,w[g+4>>2]=J);return a}catch(fc){return"undefined"!==typeof M&&fc instanceof r||z(fc),-fc.Xb}},x:function(a,b){N=b;try{var c=pc(),d=P();
-return oc(dc,c,d)}catch(e){return"undefined"!==typeof M&&e instanceof r||z(e),-e.Xb}},R:function(a,b){N=b;try{var c=pc(),d=P();return oc(ec,c,d)}catch(e){return"undefined"!==typeof M&&e instanceof r||z(e),-e.Xb}},ya:function(a,b){N=b;try{var c=Q(),d=P();return oc(dc,c.path,d)}catch(e){return"undefined"!==typeof M&&e instanceof r||z(e),-e.Xb}},xa:function(a,b){N=b;return 0},wa:function(a,b){N=b;try{var c=Q(),d=P(),e=P();if(!c.qc){var g=l(c.path,{uc:!0}).node;if(!g.Tb.Ic)throw new r(54);var k=g.Tb.Ic(g);
-c.qc=k}a=0;for(var m=hc(c,0,1),q=Math.floor(m/280);q<c.qc.length&&a+280<=e;){var n=c.qc[q];if("."===n[0]){var p=1;var x=4}else{var C=I(c.node,n);p=C.id;x=8192===(C.mode&61440)?2:t(C.mode)?4:40960===(C.mode&61440)?10:8}F=[p>>>0,(E=p,1<=+Za(E)?0<E?(bb(+ab(E/4294967296),4294967295)|0)>>>0:~~+$a((E-+(~~E>>>0))/4294967296)>>>0:0)];w[d+a>>2]=F[0];w[d+a+4>>2]=F[1];F=[280*(q+1)>>>0,(E=280*(q+1),1<=+Za(E)?0<E?(bb(+ab(E/4294967296),4294967295)|0)>>>0:~~+$a((E-+(~~E>>>0))/4294967296)>>>0:0)];w[d+a+8>>2]=F[0];
-w[d+a+12>>2]=F[1];Ma[d+a+16>>1]=280;A[d+a+18>>0]=x;Ga(n,B,d+a+19,256);a+=280;q+=1}hc(c,280*q,0);return a}catch(y){return"undefined"!==typeof M&&y instanceof r||z(y),-y.Xb}},w:function(a,b){N=b;try{var c=Q();switch(P()){case 0:var d=P();return 0>d?-28:da(c.path,c.flags,0,d).mc;case 1:case 2:return 0;case 3:return c.flags;case 4:return d=P(),c.flags|=d,0;case 12:return d=P(),Ma[d+0>>1]=2,0;case 13:case 14:return 0;case 16:case 8:return-28;case 9:return sb(),-1;default:return-28}}catch(e){return"undefined"!==
-typeof M&&e instanceof r||z(e),-e.Xb}},va:function(a,b){N=b;try{var c=Q(),d=P(),e=P();return ic(c,d,e)}catch(g){return"undefined"!==typeof M&&g instanceof r||z(g),-g.Xb}},ua:function(a,b){N=b;try{var c=pc();var d=P();if(d&-8)var e=-28;else{var g;(g=l(c,{uc:!0}).node)?(a="",d&4&&(a+="r"),d&2&&(a+="w"),d&1&&(a+="x"),e=a&&ba(g,a)?-2:0):e=-44}return e}catch(k){return"undefined"!==typeof M&&k instanceof r||z(k),-k.Xb}},ta:function(a,b){N=b;try{P();P();P();var c=P();c&&(w[c>>2]=-1,w[c+4>>2]=-1,w[c+8>>2]=
--1,w[c+12>>2]=-1);return 0}catch(d){return"undefined"!==typeof M&&d instanceof r||z(d),-d.Xb}},sa:function(a,b){N=b;try{var c=pc(),d=pc(),e=qb(c),g=qb(d),k=rb(c),m=rb(d);try{var q=l(c,{parent:!0});var n=q.node;q=l(d,{parent:!0});var p=q.node}catch(J){throw new r(10);}if(!n||!p)throw new r(44);if(n.fc!==p.fc)throw new r(75);var x=I(n,k),C=wb(c,g);if("."!==C.charAt(0))throw new r(28);C=wb(d,e);if("."!==C.charAt(0))throw new r(55);try{var y=I(p,m)}catch(J){}if(x!==y){var ia=t(x.mode),Z=Wb(n,k,ia);if(Z)throw new r(Z);
-if(Z=y?Wb(p,m,ia):Vb(p,m))throw new r(Z);if(!n.Tb.Jc)throw new r(63);if(x.oc||y&&y.oc)throw new r(10);if(p!==n&&(Z=ba(n,"w")))throw new r(Z);try{L.willMovePath&&L.willMovePath(c,d)}catch(J){console.log("FS.trackingDelegate['willMovePath']('"+c+"', '"+d+"') threw an exception: "+J.message)}Rb(x);try{n.Tb.Jc(x,p,m)}catch(J){throw J;}finally{Qb(x)}try{if(L.onMovePath)L.onMovePath(c,d)}catch(J){console.log("FS.trackingDelegate['onMovePath']('"+c+"', '"+d+"') threw an exception: "+J.message)}}return 0}catch(J){return"undefined"!==
-typeof M&&J instanceof r||z(J),-J.Xb}},ra:function(a,b){N=b;try{var c=Q(),d=P(),e=P();return ea(c,A,d,e)}catch(g){return"undefined"!==typeof M&&g instanceof r||z(g),-g.Xb}},qa:function(a,b){N=b;try{var c=pc(),d=l(c,{parent:!0}).node,e=rb(c),g=I(d,e),k=Wb(d,e,!0);if(k)throw new r(k);if(!d.Tb.Kc)throw new r(63);if(g.oc)throw new r(10);try{L.willDeletePath&&L.willDeletePath(c)}catch(m){console.log("FS.trackingDelegate['willDeletePath']('"+c+"') threw an exception: "+m.message)}d.Tb.Kc(d,e);Rb(g);try{if(L.onDeletePath)L.onDeletePath(c)}catch(m){console.log("FS.trackingDelegate['onDeletePath']('"+
-c+"') threw an exception: "+m.message)}return 0}catch(m){return"undefined"!==typeof M&&m instanceof r||z(m),-m.Xb}},Q:function(a,b){N=b;try{var c=pc(),d=P(),e=P();return da(c,d,e).mc}catch(g){return"undefined"!==typeof M&&g instanceof r||z(g),-g.Xb}},P:function(a,b){N=b;try{var c=Q(),d=P();switch(d){case 21509:case 21505:return c.$b?0:-59;case 21510:case 21511:case 21512:case 21506:case 21507:case 21508:return c.$b?0:-59;case 21519:if(!c.$b)return-59;var e=P();return w[e>>2]=0;case 21520:return c.$b?
--28:-59;case 21531:a=e=P();if(!c.Ub.td)throw new r(59);return c.Ub.td(c,d,a);case 21523:return c.$b?0:-59;case 21524:return c.$b?0:-59;default:z("bad ioctl syscall "+d)}}catch(g){return"undefined"!==typeof M&&g instanceof r||z(g),-g.Xb}},oa:function(a,b){N=b;return 0},na:function(a,b){N=b;try{P();var c=P();Rd(c,0,136);w[c>>2]=1;w[c+4>>2]=2;w[c+8>>2]=3;w[c+12>>2]=4;return 0}catch(d){return"undefined"!==typeof M&&d instanceof r||z(d),-d.Xb}},q:function(){},t:function(){return qc.apply(null,arguments)},
-O:function(){return rc.apply(null,arguments)},ma:function(){return sc.apply(null,arguments)},S:function(){return tc.apply(null,arguments)},la:function(){return uc.apply(null,arguments)},ka:function(a,b,c,d,e){var g=vc(c);b=R(b);U(a,{name:b,fromWireType:function(a){return!!a},toWireType:function(a,b){return b?d:e},argPackAdvance:8,readValueFromPointer:function(a){if(1===c)var d=A;else if(2===c)d=Ma;else if(4===c)d=w;else throw new TypeError("Unknown boolean type size: "+b);return this.fromWireType(d[a>>
-g])},ic:null})},s:function(a,b,c,d,e,g,k,m,q,n,p,x,C){p=R(p);g=W(e,g);m&&(m=W(k,m));n&&(n=W(q,n));C=W(x,C);var y=Ac(p);Sc(y,function(){id("Cannot construct "+p+" due to unbound types",[d])});T([a,b,c],d?[d]:[],function(b){b=b[0];if(d){var c=b.Vb;var e=c.nc}else e=Pc.prototype;b=Bc(y,function(){if(Object.getPrototypeOf(this)!==k)throw new Dc("Use 'new' to construct "+p);if(void 0===q.pc)throw new Dc(p+" has no accessible constructor");var a=q.pc[arguments.length];if(void 0===a)throw new Dc("Tried to invoke ctor of "+
-p+" with invalid number of parameters ("+arguments.length+") - expected ("+Object.keys(q.pc).toString()+") parameters instead!");return a.apply(this,arguments)});var k=Object.create(e,{constructor:{value:b}});b.prototype=k;var q=new Tc(p,b,k,C,c,g,m,n);c=new V(p,q,!0,!1);e=new V(p+"*",q,!1,!1);var ia=new V(p+" const*",q,!1,!0);Qc[a]={pointerType:e,kd:ia};ed(y,b);return[c,e,ia]})},M:function(a,b,c,d,e,g){var k=jd(b,c);e=W(d,e);T([],[a],function(a){a=a[0];var c="constructor "+a.name;void 0===a.Vb.pc&&
-(a.Vb.pc=[]);if(void 0!==a.Vb.pc[b-1])throw new Dc("Cannot register multiple constructors with identical number of parameters ("+(b-1)+") for class '"+a.name+"'! Overload resolution is currently only performed using the parameter count, not actual type info!");a.Vb.pc[b-1]=function(){id("Cannot construct "+a.name+" due to unbound types",k)};T([],k,function(d){a.Vb.pc[b-1]=function(){arguments.length!==b-1&&S(c+" called with "+arguments.length+" arguments, expected "+(b-1));var a=[],k=Array(b);k[0]=
-g;for(var m=1;m<b;++m)k[m]=d[m].toWireType(a,arguments[m-1]);k=e.apply(null,k);kd(a);return d[0].fromWireType(k)};return[]});return[]})},j:function(a,b,c,d,e,g,k,m){var q=jd(c,d);b=R(b);g=W(e,g);T([],[a],function(a){function d(){id("Cannot call "+e+" due to unbound types",q)}a=a[0];var e=a.name+"."+b;m&&a.Vb.zd.push(b);var n=a.Vb.nc,y=n[b];void 0===y||void 0===y.bc&&y.className!==a.name&&y.Ec===c-2?(d.Ec=c-2,d.className=a.name,n[b]=d):(Rc(n,b,e),n[b].bc[c-2]=d);T([],q,function(d){d=md(e,d,a,g,k);
-void 0===n[b].bc?(d.Ec=c-2,n[b]=d):n[b].bc[c-2]=d;return[]});return[]})},g:function(a,b,c,d,e,g,k,m,q,n){b=R(b);e=W(d,e);T([],[a],function(a){a=a[0];var d=a.name+"."+b,p={get:function(){id("Cannot access "+d+" due to unbound types",[c,k])},enumerable:!0,configurable:!0};q?p.set=function(){id("Cannot access "+d+" due to unbound types",[c,k])}:p.set=function(){S(d+" is a read-only property")};Object.defineProperty(a.Vb.nc,b,p);T([],q?[c,k]:[c],function(c){var k=c[0],y={get:function(){var b=nd(this,
-a,d+" getter");return k.fromWireType(e(g,b))},enumerable:!0};if(q){q=W(m,q);var p=c[1];y.set=function(b){var c=nd(this,a,d+" setter"),e=[];q(n,c,p.toWireType(e,b));kd(e)}}Object.defineProperty(a.Vb.nc,b,y);return[]});return[]})},L:function(a,b,c){a=R(a);T([],[b],function(b){b=b[0];f[a]=b.fromWireType(c);return[]})},ja:function(a,b){b=R(b);U(a,{name:b,fromWireType:function(a){var b=Y[a].value;pd(a);return b},toWireType:function(a,b){return Yc(b)},argPackAdvance:8,readValueFromPointer:$c,ic:null})},
-K:function(a,b,c,d){function e(){}c=vc(c);b=R(b);e.values={};U(a,{name:b,constructor:e,fromWireType:function(a){return this.constructor.values[a]},toWireType:function(a,b){return b.value},argPackAdvance:8,readValueFromPointer:qd(b,c,d),ic:null});Sc(b,e)},J:function(a,b,c){var d=rd(a,"enum");b=R(b);a=d.constructor;d=Object.create(d.constructor.prototype,{value:{value:c},constructor:{value:Bc(d.name+"_"+b,function(){})}});a.values[c]=d;a[b]=d},I:function(a,b,c){c=vc(c);b=R(b);U(a,{name:b,fromWireType:function(a){return a},
-toWireType:function(a,b){if("number"!==typeof b&&"boolean"!==typeof b)throw new TypeError('Cannot convert "'+Wc(b)+'" to '+this.name);return b},argPackAdvance:8,readValueFromPointer:sd(b,c),ic:null})},H:function(a,b,c,d,e,g){var k=jd(b,c);a=R(a);e=W(d,e);Sc(a,function(){id("Cannot call "+a+" due to unbound types",k)},b-1);T([],k,function(c){ed(a,md(a,[c[0],null].concat(c.slice(1)),null,e,g),b-1);return[]})},m:function(a,b,c,d,e){function g(a){return a}b=R(b);-1===e&&(e=4294967295);var k=vc(c);if(0===
-d){var m=32-8*c;g=function(a){return a<<m>>>m}}var q=-1!=b.indexOf("unsigned");U(a,{name:b,fromWireType:g,toWireType:function(a,c){if("number"!==typeof c&&"boolean"!==typeof c)throw new TypeError('Cannot convert "'+Wc(c)+'" to '+this.name);if(c<d||c>e)throw new TypeError('Passing a number "'+Wc(c)+'" from JS side to C/C++ side to an argument of type "'+b+'", which is outside the valid range ['+d+", "+e+"]!");return q?c>>>0:c|0},argPackAdvance:8,readValueFromPointer:td(b,k,0!==d),ic:null})},f:function(a,
-b,c){function d(a){a>>=2;var b=D;return new e(b.buffer,b[a+1],b[a])}var e=[Int8Array,Uint8Array,Int16Array,Uint16Array,Int32Array,Uint32Array,Float32Array,Float64Array][b];c=R(c);U(a,{name:c,fromWireType:d,argPackAdvance:8,readValueFromPointer:d},{sd:!0})},F:function(a,b){b=R(b);var c="std::string"===b;U(a,{name:b,fromWireType:function(a){var b=D[a>>2];if(c){var d=B[a+4+b],k=0;0!=d&&(k=d,B[a+4+b]=0);var m=a+4;for(d=0;d<=b;++d){var q=a+4+d;if(0==B[q]){m=Fa(m);if(void 0===n)var n=m;else n+=String.fromCharCode(0),
-n+=m;m=q+1}}0!=k&&(B[a+4+b]=k)}else{n=Array(b);for(d=0;d<b;++d)n[d]=String.fromCharCode(B[a+4+d]);n=n.join("")}X(a);return n},toWireType:function(a,b){b instanceof ArrayBuffer&&(b=new Uint8Array(b));var d="string"===typeof b;d||b instanceof Uint8Array||b instanceof Uint8ClampedArray||b instanceof Int8Array||S("Cannot pass non-string to std::string");var e=(c&&d?function(){return Ha(b)}:function(){return b.length})(),m=Ca(4+e+1);D[m>>2]=e;if(c&&d)Ga(b,B,m+4,e+1);else if(d)for(d=0;d<e;++d){var q=b.charCodeAt(d);
-255<q&&(X(m),S("String has UTF-16 code units that do not fit in 8 bits"));B[m+4+d]=q}else for(d=0;d<e;++d)B[m+4+d]=b[d];null!==a&&a.push(X,m);return m},argPackAdvance:8,readValueFromPointer:$c,ic:function(a){X(a)}})},ia:function(a,b,c){c=R(c);if(2===b){var d=function(){return Na};var e=1}else 4===b&&(d=function(){return D},e=2);U(a,{name:c,fromWireType:function(a){for(var b=d(),c=D[a>>2],g=Array(c),n=a+4>>e,p=0;p<c;++p)g[p]=String.fromCharCode(b[n+p]);X(a);return g.join("")},toWireType:function(a,
-c){var g=c.length,k=Ca(4+g*b),n=d();D[k>>2]=g;for(var p=k+4>>e,x=0;x<g;++x)n[p+x]=c.charCodeAt(x);null!==a&&a.push(X,k);return k},argPackAdvance:8,readValueFromPointer:$c,ic:function(a){X(a)}})},ha:function(a,b){b=R(b);U(a,{Nd:!0,name:b,argPackAdvance:0,fromWireType:function(){},toWireType:function(){}})},ga:pd,fa:function(a){4<a&&(Y[a].Vc+=1)},E:function(a,b){a=rd(a,"_emval_take_value");a=a.readValueFromPointer(b);return Yc(a)},__memory_base:1024,__table_base:0,a:function(){z()},ea:ud,da:function(a,
-b){if(0===a)a=Date.now();else if(1===a&&"object"===typeof performance&&performance&&"function"===typeof performance.now)a=vd();else return sb(),-1;w[b>>2]=a/1E3|0;w[b+4>>2]=a%1E3*1E6|0;return 0},ca:ua,ba:function(a,b,c){B.set(B.subarray(b,b+c),a)},aa:function(a){if(2147418112<a)return!1;for(var b=Math.max(ua(),16777216);b<a;)536870912>=b?b=Ka(2*b):b=Math.min(Ka((3*b+2147483648)/4),2147418112);a:{try{ya.grow(b-La.byteLength+65535>>16);Qa(ya.buffer);var c=1;break a}catch(d){}c=void 0}return c?!0:!1},
-p:function(a){Sd(a)},$:Za,i:wd,_:function(a){var b=Date.now();w[a>>2]=b/1E3|0;w[a+4>>2]=b%1E3*1E3|0;return 0},Z:function(a){return xd(a,3985040)},C:xd,l:yd,e:function(a){return yd(a)},X:zd,k:function(a){return zd(a)},d:Ad,o:function(a){return Ad(a)},v:function(a){var b=Bd.ec[a];Bd.ec.splice(a,1);Td(b)},B:Bd,W:function(){z("trap!")},V:cb,A:function(a){return Id(a,3985040)},u:Id,T:function(a){Dd();var b=new Date(w[a+20>>2]+1900,w[a+16>>2],w[a+12>>2],w[a+8>>2],w[a+4>>2],w[a>>2],0),c=w[a+32>>2],d=b.getTimezoneOffset(),
-e=new Date(b.getFullYear(),0,1),g=(new Date(b.getFullYear(),6,1)).getTimezoneOffset(),k=e.getTimezoneOffset(),m=Math.min(k,g);0>c?w[a+32>>2]=Number(g!=k&&m==d):0<c!=(m==d)&&(g=Math.max(k,g),b.setTime(b.getTime()+6E4*((0<c?m:g)-d)));w[a+24>>2]=b.getDay();w[a+28>>2]=(b.getTime()-e.getTime())/864E5|0;return b.getTime()/1E3|0},z:function(a,b){if(0===a)return sb(),-1;var c=w[a>>2];a=w[a+4>>2];if(0>a||999999999<a||0>c)return sb(),-1;0!==b&&(w[b>>2]=0,w[b+4>>2]=0);b=(1E6*c+a/1E3)/1E3;if((oa||pa)&&self.performance&&
-self.performance.now)for(c=self.performance.now();self.performance.now()-c<b;);else for(c=Date.now();Date.now()-c<b;);return 0},h:function(){return 0},r:function(a,b,c,d){function e(a,b,c){for(a="number"===typeof a?a.toString():a||"";a.length<b;)a=c[0]+a;return a}function g(a,b){return e(a,b,"0")}function k(a,b){function c(a){return 0>a?-1:0<a?1:0}var d;0===(d=c(a.getFullYear()-b.getFullYear()))&&0===(d=c(a.getMonth()-b.getMonth()))&&(d=c(a.getDate()-b.getDate()));return d}function m(a){switch(a.getDay()){case 0:return new Date(a.getFullYear()-
-1,11,29);case 1:return a;case 2:return new Date(a.getFullYear(),0,3);case 3:return new Date(a.getFullYear(),0,2);case 4:return new Date(a.getFullYear(),0,1);case 5:return new Date(a.getFullYear()-1,11,31);case 6:return new Date(a.getFullYear()-1,11,30)}}function q(a){a=Nd(new Date(a.cc+1900,0,1),a.Oc);var b=m(new Date(a.getFullYear()+1,0,4));return 0>=k(m(new Date(a.getFullYear(),0,4)),a)?0>=k(b,a)?a.getFullYear()+1:a.getFullYear():a.getFullYear()-1}var n=w[d+40>>2];d={Hd:w[d>>2],Gd:w[d+4>>2],Mc:w[d+
-8>>2],Cc:w[d+12>>2],xc:w[d+16>>2],cc:w[d+20>>2],Nc:w[d+24>>2],Oc:w[d+28>>2],Qd:w[d+32>>2],Fd:w[d+36>>2],Id:n?Fa(n):""};c=Fa(c);n={"%c":"%a %b %d %H:%M:%S %Y","%D":"%m/%d/%y","%F":"%Y-%m-%d","%h":"%b","%r":"%I:%M:%S %p","%R":"%H:%M","%T":"%H:%M:%S","%x":"%m/%d/%y","%X":"%H:%M:%S","%Ec":"%c","%EC":"%C","%Ex":"%m/%d/%y","%EX":"%H:%M:%S","%Ey":"%y","%EY":"%Y","%Od":"%d","%Oe":"%e","%OH":"%H","%OI":"%I","%Om":"%m","%OM":"%M","%OS":"%S","%Ou":"%u","%OU":"%U","%OV":"%V","%Ow":"%w","%OW":"%W","%Oy":"%y"};
-for(var p in n)c=c.replace(new RegExp(p,"g"),n[p]);var x="Sunday Monday Tuesday Wednesday Thursday Friday Saturday".split(" "),C="January February March April May June July August September October November December".split(" ");n={"%a":function(a){return x[a.Nc].substring(0,3)},"%A":function(a){return x[a.Nc]},"%b":function(a){return C[a.xc].substring(0,3)},"%B":function(a){return C[a.xc]},"%C":function(a){return g((a.cc+1900)/100|0,2)},"%d":function(a){return g(a.Cc,2)},"%e":function(a){return e(a.Cc,
-2," ")},"%g":function(a){return q(a).toString().substring(2)},"%G":function(a){return q(a)},"%H":function(a){return g(a.Mc,2)},"%I":function(a){a=a.Mc;0==a?a=12:12<a&&(a-=12);return g(a,2)},"%j":function(a){return g(a.Cc+Kd(Jd(a.cc+1900)?Ld:Md,a.xc-1),3)},"%m":function(a){return g(a.xc+1,2)},"%M":function(a){return g(a.Gd,2)},"%n":function(){return"\n"},"%p":function(a){return 0<=a.Mc&&12>a.Mc?"AM":"PM"},"%S":function(a){return g(a.Hd,2)},"%t":function(){return"\t"},"%u":function(a){return a.Nc||
-7},"%U":function(a){var b=new Date(a.cc+1900,0,1),c=0===b.getDay()?b:Nd(b,7-b.getDay());a=new Date(a.cc+1900,a.xc,a.Cc);return 0>k(c,a)?g(Math.ceil((31-c.getDate()+(Kd(Jd(a.getFullYear())?Ld:Md,a.getMonth()-1)-31)+a.getDate())/7),2):0===k(c,b)?"01":"00"},"%V":function(a){var b=m(new Date(a.cc+1900,0,4)),c=m(new Date(a.cc+1901,0,4)),d=Nd(new Date(a.cc+1900,0,1),a.Oc);return 0>k(d,b)?"53":0>=k(c,d)?"01":g(Math.ceil((b.getFullYear()<a.cc+1900?a.Oc+32-b.getDate():a.Oc+1-b.getDate())/7),2)},"%w":function(a){return a.Nc},
-"%W":function(a){var b=new Date(a.cc,0,1),c=1===b.getDay()?b:Nd(b,0===b.getDay()?1:7-b.getDay()+1);a=new Date(a.cc+1900,a.xc,a.Cc);return 0>k(c,a)?g(Math.ceil((31-c.getDate()+(Kd(Jd(a.getFullYear())?Ld:Md,a.getMonth()-1)-31)+a.getDate())/7),2):0===k(c,b)?"01":"00"},"%y":function(a){return(a.cc+1900).toString().substring(2)},"%Y":function(a){return a.cc+1900},"%z":function(a){a=a.Fd;var b=0<=a;a=Math.abs(a)/60;return(b?"+":"-")+String("0000"+(a/60*100+a%60)).slice(-4)},"%Z":function(a){return a.Id},
-"%%":function(){return"%"}};for(p in n)0<=c.indexOf(p)&&(c=c.replace(new RegExp(p,"g"),n[p](d)));p=Bb(c,!1);if(p.length>b)return 0;A.set(p,a);return p.length-1},y:function(a){var b=Date.now()/1E3|0;a&&(w[a>>2]=b);return b},c:z,memory:ya,n:function(){},table:za},Ud=f.asm({},lb,La);f.asm=Ud;var Qd=f.__ZSt18uncaught_exceptionv=function(){return f.asm.za.apply(null,arguments)};f.___embind_register_native_and_builtin_types=function(){return f.asm.Aa.apply(null,arguments)};
-f.___errno_location=function(){return f.asm.Ba.apply(null,arguments)};var hd=f.___getTypeName=function(){return f.asm.Ca.apply(null,arguments)},Gd=f.__get_daylight=function(){return f.asm.Da.apply(null,arguments)},Fd=f.__get_timezone=function(){return f.asm.Ea.apply(null,arguments)},Hd=f.__get_tzname=function(){return f.asm.Fa.apply(null,arguments)},X=f._free=function(){return f.asm.Ga.apply(null,arguments)};f._main=function(){return f.asm.Ha.apply(null,arguments)};
-var Ca=f._malloc=function(){return f.asm.Ia.apply(null,arguments)},Rd=f._memset=function(){return f.asm.Ja.apply(null,arguments)},mb=f.globalCtors=function(){return f.asm.Nb.apply(null,arguments)},Ja=f.stackAlloc=function(){return f.asm.Ob.apply(null,arguments)},Td=f.stackRestore=function(){return f.asm.Pb.apply(null,arguments)},Cd=f.stackSave=function(){return f.asm.Qb.apply(null,arguments)};f.dynCall_dd=function(){return f.asm.Ka.apply(null,arguments)};
-f.dynCall_did=function(){return f.asm.La.apply(null,arguments)};f.dynCall_didd=function(){return f.asm.Ma.apply(null,arguments)};f.dynCall_fii=function(){return f.asm.Na.apply(null,arguments)};f.dynCall_fiifi=function(){return f.asm.Oa.apply(null,arguments)};f.dynCall_fiii=function(){return f.asm.Pa.apply(null,arguments)};f.dynCall_fiiii=function(){return f.asm.Qa.apply(null,arguments)};f.dynCall_fiiiiiiiiffii=function(){return f.asm.Ra.apply(null,arguments)};
-f.dynCall_i=function(){return f.asm.Sa.apply(null,arguments)};f.dynCall_ii=function(){return f.asm.Ta.apply(null,arguments)};f.dynCall_iidiiii=function(){return f.asm.Ua.apply(null,arguments)};f.dynCall_iii=function(){return f.asm.Va.apply(null,arguments)};f.dynCall_iiifii=function(){return f.asm.Wa.apply(null,arguments)};f.dynCall_iiii=function(){return f.asm.Xa.apply(null,arguments)};f.dynCall_iiiii=function(){return f.asm.Ya.apply(null,arguments)};
-f.dynCall_iiiiii=function(){return f.asm.Za.apply(null,arguments)};f.dynCall_iiiiiii=function(){return f.asm._a.apply(null,arguments)};f.dynCall_iiiiiiidiiddii=function(){return f.asm.$a.apply(null,arguments)};f.dynCall_iiiiiiii=function(){return f.asm.ab.apply(null,arguments)};f.dynCall_iiiiiiiii=function(){return f.asm.bb.apply(null,arguments)};f.dynCall_iiiiiiiiii=function(){return f.asm.cb.apply(null,arguments)};f.dynCall_iiiiiiiiiiiiiifii=function(){return f.asm.db.apply(null,arguments)};
-f.dynCall_iiiiij=function(){return f.asm.eb.apply(null,arguments)};f.dynCall_iiiji=function(){return f.asm.fb.apply(null,arguments)};f.dynCall_iiijjji=function(){return f.asm.gb.apply(null,arguments)};f.dynCall_iij=function(){return f.asm.hb.apply(null,arguments)};f.dynCall_ijiii=function(){return f.asm.ib.apply(null,arguments)};f.dynCall_jii=function(){return f.asm.jb.apply(null,arguments)};f.dynCall_jiiii=function(){return f.asm.kb.apply(null,arguments)};
-f.dynCall_jiiij=function(){return f.asm.lb.apply(null,arguments)};f.dynCall_jiiji=function(){return f.asm.mb.apply(null,arguments)};f.dynCall_jij=function(){return f.asm.nb.apply(null,arguments)};f.dynCall_jiji=function(){return f.asm.ob.apply(null,arguments)};f.dynCall_v=function(){return f.asm.pb.apply(null,arguments)};f.dynCall_vi=function(){return f.asm.qb.apply(null,arguments)};f.dynCall_vii=function(){return f.asm.rb.apply(null,arguments)};
-f.dynCall_viidi=function(){return f.asm.sb.apply(null,arguments)};f.dynCall_viifi=function(){return f.asm.tb.apply(null,arguments)};f.dynCall_viii=function(){return f.asm.ub.apply(null,arguments)};f.dynCall_viiif=function(){return f.asm.vb.apply(null,arguments)};f.dynCall_viiiff=function(){return f.asm.wb.apply(null,arguments)};f.dynCall_viiii=function(){return f.asm.xb.apply(null,arguments)};f.dynCall_viiiif=function(){return f.asm.yb.apply(null,arguments)};
-f.dynCall_viiiifii=function(){return f.asm.zb.apply(null,arguments)};f.dynCall_viiiii=function(){return f.asm.Ab.apply(null,arguments)};f.dynCall_viiiiii=function(){return f.asm.Bb.apply(null,arguments)};f.dynCall_viiiiiiff=function(){return f.asm.Cb.apply(null,arguments)};f.dynCall_viiiiiifi=function(){return f.asm.Db.apply(null,arguments)};f.dynCall_viiiiiii=function(){return f.asm.Eb.apply(null,arguments)};f.dynCall_viiiiiiifi=function(){return f.asm.Fb.apply(null,arguments)};
-f.dynCall_viiiiiiii=function(){return f.asm.Gb.apply(null,arguments)};f.dynCall_viiiiiiiii=function(){return f.asm.Hb.apply(null,arguments)};f.dynCall_viiiiiiiiii=function(){return f.asm.Ib.apply(null,arguments)};f.dynCall_viiiiiiiiiii=function(){return f.asm.Jb.apply(null,arguments)};f.dynCall_viiiiiiiiiiii=function(){return f.asm.Kb.apply(null,arguments)};f.dynCall_viiiiiiiiiiiiii=function(){return f.asm.Lb.apply(null,arguments)};f.dynCall_viiijj=function(){return f.asm.Mb.apply(null,arguments)};
-f.asm=Ud;var Vd;f.then=function(a){if(Vd)a(f);else{var b=f.onRuntimeInitialized;f.onRuntimeInitialized=function(){b&&b();a(f)}}return f};function Wd(a){this.name="ExitStatus";this.message="Program terminated with exit("+a+")";this.status=a}fb=function Zd(){Vd||$d();Vd||(fb=Zd)};
-function ha(a){var b=f._main;a=a||[];var c=a.length+1,d=Ja(4*(c+1));w[d>>2]=Ia(ma);for(var e=1;e<c;e++)w[(d>>2)+e]=Ia(a[e-1]);w[(d>>2)+c]=0;try{var g=b(c,d);Sd(g,!0)}catch(k){k instanceof Wd||("SimulateInfiniteLoop"==k?xa=!0:((a=k)&&"object"===typeof k&&k.stack&&(a=[k,k.stack]),v("exception thrown: "+a),na(1,k)))}finally{}}
-function $d(a){function b(){if(!Vd&&(Vd=!0,!Aa)){Xa=!0;f.noFSInit||kc||(kc=!0,jc(),f.stdin=f.stdin,f.stdout=f.stdout,f.stderr=f.stderr,f.stdin?mc("stdin",f.stdin):cc("/dev/tty","/dev/stdin"),f.stdout?mc("stdout",null,f.stdout):cc("/dev/tty","/dev/stdout"),f.stderr?mc("stderr",null,f.stderr):cc("/dev/tty1","/dev/stderr"),da("/dev/stdin","r"),da("/dev/stdout","w"),da("/dev/stderr","w"));Sa(Ua);Mb=!1;Sa(Va);if(f.onRuntimeInitialized)f.onRuntimeInitialized();ae&&ha(a);if(f.postRun)for("function"==typeof f.postRun&&
-(f.postRun=[f.postRun]);f.postRun.length;){var b=f.postRun.shift();Wa.unshift(b)}Sa(Wa)}}a=a||la;if(!(0<db)){if(f.preRun)for("function"==typeof f.preRun&&(f.preRun=[f.preRun]);f.preRun.length;)Ya();Sa(Ta);0<db||(f.setStatus?(f.setStatus("Running..."),setTimeout(function(){setTimeout(function(){f.setStatus("")},1);b()},1)):b())}}f.run=$d;function Sd(a,b){if(!b||!xa||0!==a){if(!xa&&(Aa=!0,f.onExit))f.onExit(a);na(a,new Wd(a))}}
-if(f.preInit)for("function"==typeof f.preInit&&(f.preInit=[f.preInit]);0<f.preInit.length;)f.preInit.pop()();var ae=!1;f.noInitialRun&&(ae=!1);xa=!0;$d();
-
-
-  return ffmpeg
-}
-);
-})();
-if (typeof exports === 'object' && typeof module === 'object')
-      module.exports = ffmpeg;
-    else if (typeof define === 'function' && define['amd'])
-      define([], function() { return ffmpeg; });
-    else if (typeof exports === 'object')
-      exports["ffmpeg"] = ffmpeg;
-    
\ No newline at end of file
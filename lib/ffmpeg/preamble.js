@@ -1,8 +1,32 @@
-/* global FS, Module, callMain */
+/* global FS, HEAPU8, Module, PThread, _free, _malloc */
 /* eslint-disable no-var */
 
-var initializedFS = false
-var DATA_DIR = '/data'
+var transcoder = null
+var capabilities = null
+var autoPreset = null
+// Set by a cancel of the current job, which the transcoder forgets once its
+// next run begins
+var cancelPending = false
+
+// x264's presets from the slowest, which compresses best, to the fastest
+var X264_PRESETS = [
+  'veryslow',
+  'slower',
+  'slow',
+  'medium',
+  'fast',
+  'faster',
+  'veryfast',
+  'superfast',
+  'ultrafast',
+]
+
+// Seconds of the input encoded by each trial of the auto preset
+var AUTO_TRIAL_SECONDS = 1
+
+// Milliseconds between the progress reports of a trial, how late one that
+// runs over its budget is stopped
+var AUTO_TRIAL_INTERVAL = 50
 
 function convertToUint8Array(data) {
   if (Array.isArray(data) || data instanceof ArrayBuffer) {
@@ -17,37 +41,482 @@ function convertToUint8Array(data) {
   return data
 }
 
-Module['convert'] = function(data, opts) {
-  if (!initializedFS) {
-    FS.mkdir(DATA_DIR)
-    FS.chdir(DATA_DIR)
-    initializedFS = true
+// `input` is either the file contents, which are copied once into the wasm
+// heap, or a `{ size, read(offset, length) }` reader that is pulled in chunks
+function withInputSource(input, callback) {
+  if (input && typeof input['read'] === 'function') {
+    var readerSource = Module['InputSource']['fromReader'](input, input['size'])
+
+    try {
+      return callback(readerSource)
+    } finally {
+      readerSource['delete']()
+    }
+  }
+
+  var data = convertToUint8Array(input)
+  var ptr = _malloc(data.length)
+
+  if (!ptr) {
+    throw new Error('Not enough memory to load the input')
+  }
+
+  HEAPU8.set(data, ptr)
+
+  var bufferSource = Module['InputSource']['fromBuffer'](ptr, data.length)
+
+  try {
+    return callback(bufferSource)
+  } finally {
+    bufferSource['delete']()
+    _free(ptr)
+  }
+}
+
+function getTranscoder() {
+  if (!transcoder) {
+    transcoder = new Module['Transcoder']()
+  }
+  return transcoder
+}
+
+function createOutputSink(onChunk) {
+  return onChunk
+    ? Module['OutputSink']['toCallback'](function(view) {
+        // the view points into the wasm heap, which is reused after this call
+        onChunk(view.slice())
+      })
+    : Module['OutputSink']['toBuffer']()
+}
+
+// Runs `job` on the shared transcoder. An exception thrown from a JS callback
+// unwinds through the native code without cleaning up, so the job's contexts
+// are released here in that case.
+function runTranscoder(job) {
+  var instance = getTranscoder()
+
+  try {
+    return job(instance)
+  } catch (err) {
+    instance['reset']()
+    throw err
+  }
+}
+
+// A job cancelled through `onProgress` or `Module.cancel` fails with an
+// AbortError, so callers can tell it apart from an actual failure
+function checkResult(ret, message) {
+  if (ret === Module['AVERROR_EXIT']) {
+    var abortError = new Error('Conversion cancelled')
+    abortError.name = 'AbortError'
+    throw abortError
+  }
+
+  if (ret < 0) {
+    throw new Error(message + ': ' + Module['error_string'](ret))
+  }
+}
+
+function probeSource(source, opts) {
+  var info = {}
+
+  checkResult(Module['probe_input'](source, opts || {}, info), 'Probe failed')
+
+  return info
+}
+
+function convertSource(source, opts, onChunk) {
+  var sink = createOutputSink(onChunk)
+
+  try {
+    var ret = runTranscoder(function(instance) {
+      return instance['run'](source, sink, opts)
+    })
+
+    checkResult(ret, 'Conversion failed')
+
+    return onChunk ? null : sink['data']().slice()
+  } finally {
+    sink['delete']()
+  }
+}
+
+// Encodes the first seconds of the range with `preset`, throwing the output
+// away, and returns the seconds each frame took in the pipeline, leaving out
+// opening and seeking the input. A trial that runs longer than `frameBudget`
+// allows is stopped early and returns Infinity, one that measured nothing
+// returns 0.
+function runPresetTrial(source, options, preset, trial) {
+  var sink = Module['OutputSink']['toBuffer']()
+  var startedAt = Date.now()
+  var lastProgress = null
+  var overBudget = false
+
+  try {
+    var ret = runTranscoder(function(instance) {
+      return instance['run'](
+        source,
+        sink,
+        Object.assign({}, options, {
+          'preset': preset,
+          'startTime': trial.startTime,
+          'endTime': trial.endTime,
+          'progressInterval': AUTO_TRIAL_INTERVAL,
+          'onProgress': function(progress) {
+            lastProgress = progress
+
+            if (trial.onProgress()) {
+              cancelPending = true
+            }
+
+            overBudget =
+              (Date.now() - startedAt) / 1000 >
+              trial.frameBudget * trial.frames
+
+            return cancelPending || overBudget
+          },
+        })
+      )
+    })
+
+    if (overBudget && !cancelPending && ret === Module['AVERROR_EXIT']) {
+      return Infinity
+    }
+
+    checkResult(ret, 'Conversion failed')
+  } finally {
+    sink['delete']()
+  }
+
+  var stats = Module['getStats']()
+  var frames = lastProgress ? lastProgress['frames'] : 0
+  var time =
+    stats['demuxTime'] +
+    stats['decodeTime'] +
+    stats['filterTime'] +
+    stats['encodeTime'] +
+    stats['muxTime']
+
+  return frames && time > 0 ? time / frames : 0
+}
+
+// Picks the slowest x264 preset, which compresses best, that is expected to
+// finish the job within `opts.deadline` seconds (the length of the converted
+// range by default). The presets are tried on the first second of the range,
+// ultrafast first and then a binary search between it and veryslow, assuming
+// a slower preset never encodes faster. Each trial is stopped as soon as it
+// goes over the time its frames are allowed. When even ultrafast is too slow
+// the video is also scaled down, unless the job sets its own size. Keys are
+// quoted so closure doesn't rename them.
+function resolveAutoPreset(source, opts) {
+  var start = Date.now()
+  var options = Object.assign({}, opts, { 'preset': undefined })
+  var info = probeSource(source, { 'keyframes': 'none' })
+  var video =
+    info['videoStream'] === null ? null : info['streams'][info['videoStream']]
+  var startTime = opts['startTime'] > 0 ? opts['startTime'] : 0
+  var endTime = opts['endTime'] > 0 ? opts['endTime'] : info['duration']
+  // what the caller is told while the trials run: nothing of its job is done
+  // yet, this only gives it a chance to cancel
+  var pendingProgress = {
+    'packets': 0,
+    'frames': 0,
+    'time': startTime,
+    'duration': info['duration'],
+    'fps': 0,
+    'bytes': 0,
+  }
+
+  // without a known length there's nothing to plan against, the encoder's
+  // defaults are used then
+  if (!video || opts['videoEncoder'] !== 'libx264' || endTime <= startTime) {
+    return options
+  }
+
+  // a preset would keep `streamCopy` from copying the video, which beats any
+  // of them
+  if (
+    opts['streamCopy'] &&
+    runTranscoder(function(instance) {
+      return instance['copiesVideo'](source, options)
+    })
+  ) {
+    return options
+  }
+
+  var frameRate = video['frameRate'] || 25
+  var deadline = opts['deadline'] > 0 ? opts['deadline'] : endTime - startTime
+  // the trials' output is thrown away and the job encodes the whole range
+  // again, frames of the trials included
+  var frames = (endTime - startTime) * frameRate
+  var trialEnd = Math.min(endTime, startTime + AUTO_TRIAL_SECONDS)
+  var trial = {
+    startTime: startTime,
+    endTime: trialEnd,
+    frames: (trialEnd - startTime) * frameRate,
+    frameBudget: Infinity,
+    onProgress: function() {
+      return opts['onProgress'] ? opts['onProgress'](pendingProgress) : false
+    },
+  }
+  // seconds left for each frame of the job, after the trials run so far
+  var getFrameBudget = function() {
+    return (deadline - (Date.now() - start) / 1000) / frames
+  }
+
+  var ultrafastTime = runPresetTrial(source, options, 'ultrafast', trial)
+  var frameBudget = getFrameBudget()
+
+  options['preset'] = 'ultrafast'
+
+  if (!ultrafastTime || frameBudget <= 0) {
+    return options
+  }
+
+  if (ultrafastTime > frameBudget) {
+    // the time of a frame goes down with its number of pixels
+    if (!opts['width'] && !opts['height'] && video['height']) {
+      var height = Math.floor(
+        video['height'] * Math.sqrt(frameBudget / ultrafastTime)
+      )
+      var maxHeight = Math.max(2, height - (height % 2))
+
+      options['maxHeight'] = opts['maxHeight']
+        ? Math.min(opts['maxHeight'], maxHeight)
+        : maxHeight
+    }
+
+    return options
+  }
+
+  // the slowest preset known to fit, and the slowest one that might
+  var fitting = X264_PRESETS.length - 1
+  var slowest = 0
+
+  while (slowest < fitting) {
+    var middle = Math.floor((slowest + fitting) / 2)
+
+    trial.frameBudget = getFrameBudget()
+
+    var frameTime = runPresetTrial(source, options, X264_PRESETS[middle], trial)
+
+    if (frameTime && frameTime <= trial.frameBudget) {
+      fitting = middle
+    } else {
+      slowest = middle + 1
+    }
+  }
+
+  options['preset'] = X264_PRESETS[fitting]
+
+  return options
+}
+
+// Resolves the auto preset of a job. A cancel that came in after the trial's
+// last packet didn't stop the trial, and the job's own run would clear it, so
+// the job is stopped here instead.
+function resolveJobPreset(source, opts) {
+  cancelPending = false
+  autoPreset = null
+
+  if (opts['preset'] !== 'auto') {
+    return opts
   }
 
-  var fd = FS.open('input', 'w+')
-  FS.write(fd, data, 0, data.length)
-  FS.close(fd)
+  var options = resolveAutoPreset(source, opts)
+
+  autoPreset = options['preset']
 
-  var args = [
-    '-hide_banner',
-    '-nostdin',
-    '-loglevel',
-    opts['verbose'] ? 'verbose' : 'quiet',
-    '-i',
-    'input',
-    '-vcodec',
-    opts['videoEncoder'],
-    '-acodec',
-    opts['audioEncoder'],
-    '-f',
-    opts['outputFormat'],
-  ]
-    .concat(opts['extraOptions'] || [])
-    .concat(['output'])
+  if (cancelPending) {
+    checkResult(Module['AVERROR_EXIT'])
+  }
+
+  return options
+}
+
+// Without `onChunk` the whole output is returned once the job is done.
+// Otherwise it's handed to `onChunk` piece by piece while being muxed (mp4/mov
+// outputs are fragmented so they stay playable) and nothing is returned. The
+// auto preset's probe and trial read the same copy of the input as the job.
+Module['convert'] = function(input, opts, onChunk) {
+  return withInputSource(input, function(source) {
+    return convertSource(source, resolveJobPreset(source, opts), onChunk)
+  })
+}
+
+// Same as `convert` for every one of `opts.outputs`, decoding the input only
+// once. Returns the outputs in the same order, or hands their chunks to
+// `onChunk` along with the index of the output they belong to.
+Module['convertMany'] = function(input, opts, onChunk) {
+  return withInputSource(input, function(source) {
+    // planned as if there was only the job's own output
+    opts = resolveJobPreset(source, opts)
+
+    var outputs = opts['outputs'].map(function(output) {
+      return Object.assign({}, opts, output)
+    })
+    var sinks = outputs.map(function(output, i) {
+      return createOutputSink(
+        onChunk &&
+          function(chunk) {
+            onChunk(chunk, i)
+          }
+      )
+    })
+
+    try {
+      var ret = runTranscoder(function(instance) {
+        return instance['runMany'](source, sinks, outputs)
+      })
+
+      checkResult(ret, 'Conversion failed')
+
+      return onChunk
+        ? null
+        : sinks.map(function(sink) {
+            return sink['data']().slice()
+          })
+    } finally {
+      sinks.forEach(function(sink) {
+        sink['delete']()
+      })
+    }
+  })
+}
+
+// The options `convert` would run the job with once its auto preset is
+// resolved, for a job split over several calls that must all encode alike
+Module['resolvePreset'] = function(input, opts) {
+  return withInputSource(input, function(source) {
+    return resolveJobPreset(source, opts)
+  })
+}
+
+// Reads what the container headers tell about the input without decoding it
+// whole, see `ProbeOptions` in convert.d.ts
+Module['probe'] = function(input, opts) {
+  return withInputSource(input, function(source) {
+    return probeSource(source, opts)
+  })
+}
 
-  callMain(args)
+// Still images of the main video stream, each one decoding only the frames
+// since the keyframe before it, see `ThumbnailOptions` in convert.d.ts
+Module['thumbnails'] = function(input, opts) {
+  return withInputSource(input, function(source) {
+    var thumbnails = []
 
-  var outputFile = FS.lookupPath(DATA_DIR).node.contents['output']
+    checkResult(
+      Module['extract_thumbnails'](source, opts || {}, thumbnails),
+      'Thumbnail extraction failed'
+    )
 
-  return convertToUint8Array(outputFile.contents)
+    return thumbnails
+  })
+}
+
+// Cut points, in seconds, splitting the input into at most `count` segments
+// that start on a keyframe. Convert each range with `startTime`/`endTime` and
+// join the results back with `concat`.
+Module['planSegments'] = function(input, count) {
+  return withInputSource(input, function(source) {
+    return Module['plan_segments'](source, count)
+  })
+}
+
+// Joins segments produced with the same options into one `opts.outputFormat`
+// file without re-encoding them, same return value as `convert`. `cuts` are
+// the times from `planSegments` the segments were split at.
+Module['concat'] = function(segments, cuts, opts, onChunk) {
+  var dir = '/segments'
+  var listPath = dir + '/list.txt'
+  var paths = segments.map(function(segment, i) {
+    return dir + '/segment-' + i
+  })
+
+  if (!FS.analyzePath(dir).exists) {
+    FS.mkdir(dir)
+  }
+
+  var sink = createOutputSink(onChunk)
+
+  try {
+    // the concat demuxer only reads from files, so the segments go to MEMFS
+    segments.forEach(function(segment, i) {
+      FS.writeFile(paths[i], convertToUint8Array(segment))
+    })
+
+    FS.writeFile(
+      listPath,
+      paths
+        .map(function(path, i) {
+          // the segments keep the timestamps of the input and the length the
+          // demuxer reads from their headers is where they end, so each one
+          // is told where it stops for the next to be placed right after it
+          return (
+            "file '" +
+            path +
+            "'\n" +
+            (i < cuts.length ? 'outpoint ' + cuts[i] + '\n' : '')
+          )
+        })
+        .join('')
+    )
+
+    var ret = runTranscoder(function(instance) {
+      return instance['concat'](listPath, sink, opts)
+    })
+
+    checkResult(ret, 'Concatenation failed')
+
+    return onChunk ? null : sink['data']().slice()
+  } finally {
+    sink['delete']()
+    paths.concat(listPath).forEach(function(path) {
+      if (FS.analyzePath(path).exists) {
+        FS.unlink(path)
+      }
+    })
+  }
+}
+
+// Stops the running job before its next packet. The module is blocked while
+// the job runs, so this only has an effect from one of the job's callbacks.
+Module['cancel'] = function() {
+  cancelPending = true
+
+  if (transcoder) {
+    transcoder['cancel']()
+  }
+}
+
+// Stops the pthreads of the threaded build, before dropping the instance.
+// Does nothing on the other builds.
+Module['terminateThreads'] = function() {
+  if (typeof PThread !== 'undefined') {
+    PThread.terminateAllThreads()
+  }
+}
+
+// Where the last job spent its time, see `JobStats` in convert.d.ts
+Module['getStats'] = function() {
+  if (!transcoder) {
+    return null
+  }
+
+  var stats = transcoder['stats']()
+
+  if (autoPreset) {
+    stats['preset'] = autoPreset
+  }
+
+  return stats
+}
+
+// What this build can encode and mux, see `Capabilities` in convert.d.ts
+Module['getCapabilities'] = function() {
+  if (!capabilities) {
+    capabilities = JSON.parse(Module['get_capabilities']())
+  }
+  return capabilities
 }
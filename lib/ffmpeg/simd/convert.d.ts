@@ -0,0 +1,2 @@
+export * from '../convert'
+export { default as default } from '../convert'
@@ -0,0 +1,3 @@
+// The pthreads build is emitted as a file, this is its URL
+declare const url: string
+export default url
@@ -0,0 +1,3 @@
+// Script of the pthread workers, emitted as a file, this is its URL
+declare const url: string
+export default url
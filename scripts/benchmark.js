@@ -0,0 +1,630 @@
+'use strict'
+
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+// Runs the benchmark builds of ffmpeg in lib/ffmpeg/bench headlessly over a
+// matrix of inputs and output presets, and reports wall time, encode fps, peak
+// heap and output size of each combination as JSON, next to the build's code
+// size and startup time. With a baseline, the script fails when any of them
+// regressed by more than the thresholds below. With --update-manifest, the fps
+// of each build on the reference case is recorded in lib/ffmpeg/manifest.json,
+// which is what the site picks its build by. With --check-segments, each wasm
+// build also converts earth.mp4 in segments like convertSegmented does, and the
+// script fails when the joined output doesn't decode the same across the cuts.
+// With --update-readme, the code size, startup time and fps of each build on
+// the reference case replace the table in the README.
+//
+// Usage:
+//   node scripts/benchmark.js [--builds wasm,speed,asm] [--runs 3]
+//     [--output results.json] [--baseline baseline.json] [--save-baseline]
+//     [--update-manifest] [--update-readme] [--check-segments]
+//
+// The builds come from lib/ffmpeg/build.sh with BENCHMARK=1, which targets node
+// and adds the demuxers and decoders of the generated clips.
+
+process.on('unhandledRejection', err => {
+  throw err
+})
+
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const { performance } = require('perf_hooks')
+
+const ROOT_PATH = path.resolve(__dirname, '..')
+const LIB_PATH = path.join(ROOT_PATH, 'lib', 'ffmpeg', 'bench')
+const MANIFEST_PATH = path.join(ROOT_PATH, 'lib', 'ffmpeg', 'manifest.json')
+const README_PATH = path.join(ROOT_PATH, 'README.md')
+
+// The README lines between these two hold the table of --update-readme
+const README_TABLE_START = '<!-- benchmark-table -->'
+const README_TABLE_END = '<!-- /benchmark-table -->'
+
+const BUILDS = {
+  wasm: path.join(LIB_PATH, 'convert.js'),
+  simd: path.join(LIB_PATH, 'simd', 'convert.js'),
+  speed: path.join(LIB_PATH, 'speed', 'convert.js'),
+  asm: path.join(LIB_PATH, 'asm', 'convert.js'),
+}
+
+// The entry of lib/ffmpeg/manifest.json each benchmark build stands for
+const MANIFEST_BUILDS = {
+  wasm: 'default',
+  simd: 'simd',
+  speed: 'speed',
+  asm: 'asm',
+}
+
+// The case whose fps goes to the manifest: the site's default conversion of
+// the example video
+const REFERENCE_CASE = {
+  input: 'earth.mp4',
+  outputFormat: 'mp4',
+  videoEncoder: 'libx264',
+}
+
+const PRESETS = [
+  { outputFormat: 'mp4', videoEncoder: 'libx264', audioEncoder: 'aac' },
+  {
+    outputFormat: 'matroska',
+    videoEncoder: 'mpeg4',
+    audioEncoder: 'libmp3lame',
+  },
+  { outputFormat: 'avi', videoEncoder: 'mpeg4', audioEncoder: 'ac3' },
+  { outputFormat: 'gif', videoEncoder: 'gif', audioEncoder: 'aac' },
+]
+
+// How much worse than the baseline a result may get before it counts as a
+// regression, relative to the baseline value
+const THRESHOLDS = {
+  startupTime: 0.2,
+  wallTime: 0.1,
+  fps: 0.1,
+  peakHeap: 0.2,
+  outputSize: 0.05,
+}
+
+// Metrics where a lower value is the better one
+const LOWER_IS_BETTER = ['startupTime', 'wallTime', 'peakHeap', 'outputSize']
+
+function parseArgs(argv) {
+  const args = {
+    builds: ['wasm', 'asm'],
+    runs: 3,
+    output: null,
+    baseline: null,
+    saveBaseline: false,
+    updateManifest: false,
+    updateReadme: false,
+    checkSegments: false,
+  }
+
+  for (let i = 0; i < argv.length; i++) {
+    switch (argv[i]) {
+      case '--builds':
+        args.builds = argv[++i].split(',')
+        break
+      case '--runs':
+        args.runs = Math.max(1, Number(argv[++i]))
+        break
+      case '--output':
+        args.output = argv[++i]
+        break
+      case '--baseline':
+        args.baseline = argv[++i]
+        break
+      case '--save-baseline':
+        args.saveBaseline = true
+        break
+      case '--update-manifest':
+        args.updateManifest = true
+        break
+      case '--update-readme':
+        args.updateReadme = true
+        break
+      case '--check-segments':
+        args.checkSegments = true
+        break
+      default:
+        throw new Error(`Unknown argument '${argv[i]}'`)
+    }
+  }
+
+  if (args.saveBaseline && !args.baseline) {
+    throw new Error('--save-baseline needs a --baseline path')
+  }
+
+  return args
+}
+
+// Deterministic noise, so the synthetic clips encode the same on every run
+function createRandom(seed) {
+  let state = seed
+
+  return () => {
+    state = (state * 1664525 + 1013904223) >>> 0
+    return state / 0x100000000
+  }
+}
+
+// Moving gradient with some noise on top, as an uncompressed yuv4mpeg stream
+function createSyntheticVideo(width, height, frameCount) {
+  const header = Buffer.from(
+    `YUV4MPEG2 W${width} H${height} F30:1 Ip A1:1 C420jpeg\n`
+  )
+  const frameHeader = Buffer.from('FRAME\n')
+  const lumaSize = width * height
+  const chromaSize = (width / 2) * (height / 2)
+  const frameSize = frameHeader.length + lumaSize + chromaSize * 2
+  const data = Buffer.alloc(header.length + frameSize * frameCount)
+  const random = createRandom(frameCount)
+
+  header.copy(data)
+
+  for (let frame = 0; frame < frameCount; frame++) {
+    let offset = header.length + frame * frameSize
+
+    frameHeader.copy(data, offset)
+    offset += frameHeader.length
+
+    for (let y = 0; y < height; y++) {
+      for (let x = 0; x < width; x++) {
+        data[offset++] = (x + y + frame * 4 + random() * 32) & 0xff
+      }
+    }
+
+    for (let plane = 0; plane < 2; plane++) {
+      for (let i = 0; i < chromaSize; i++) {
+        data[offset++] = (128 + (plane ? frame : -frame) * 2) & 0xff
+      }
+    }
+  }
+
+  return data
+}
+
+// Stereo 16-bit sine sweep as a wav file
+function createSyntheticAudio(seconds) {
+  const sampleRate = 44100
+  const channels = 2
+  const sampleCount = sampleRate * seconds
+  const dataSize = sampleCount * channels * 2
+  const data = Buffer.alloc(44 + dataSize)
+
+  data.write('RIFF', 0)
+  data.writeUInt32LE(36 + dataSize, 4)
+  data.write('WAVE', 8)
+  data.write('fmt ', 12)
+  data.writeUInt32LE(16, 16)
+  data.writeUInt16LE(1, 20)
+  data.writeUInt16LE(channels, 22)
+  data.writeUInt32LE(sampleRate, 24)
+  data.writeUInt32LE(sampleRate * channels * 2, 28)
+  data.writeUInt16LE(channels * 2, 32)
+  data.writeUInt16LE(16, 34)
+  data.write('data', 36)
+  data.writeUInt32LE(dataSize, 40)
+
+  for (let i = 0; i < sampleCount; i++) {
+    const frequency = 220 + (i / sampleCount) * 660
+    const sample = Math.round(
+      Math.sin((2 * Math.PI * frequency * i) / sampleRate) * 0x3fff
+    )
+
+    for (let channel = 0; channel < channels; channel++) {
+      data.writeInt16LE(sample, 44 + (i * channels + channel) * 2)
+    }
+  }
+
+  return data
+}
+
+function getInputs() {
+  return [
+    {
+      name: 'earth.mp4',
+      data: fs.readFileSync(path.join(ROOT_PATH, 'examples', 'earth.mp4')),
+    },
+    {
+      name: 'synthetic-320x240.y4m',
+      data: createSyntheticVideo(320, 240, 150),
+    },
+    {
+      name: 'synthetic-1280x720.y4m',
+      data: createSyntheticVideo(1280, 720, 60),
+    },
+    { name: 'synthetic-tone.wav', data: createSyntheticAudio(10) },
+  ]
+}
+
+// Size of the compiled code the browser downloads, the wasm binary or the
+// asm.js memory initializer, plus the JS glue
+function getCodeSize(build) {
+  const script = BUILDS[build]
+  const code = fs.existsSync(script.replace(/\.js$/, '.wasm'))
+    ? script.replace(/\.js$/, '.wasm')
+    : `${script}.mem`
+
+  return fs.statSync(script).size + fs.statSync(code).size
+}
+
+function loadModule(build) {
+  // every case gets its own instance, so heap peaks of earlier cases don't
+  // leak into the next one
+  delete require.cache[require.resolve(BUILDS[build])]
+
+  const start = performance.now()
+  const factory = require(BUILDS[build])
+
+  return new Promise(resolve => {
+    const module = factory({
+      onRuntimeInitialized() {
+        // the module is a then-able resolving to itself, see src/ffmpeg/util.ts
+        delete module.then
+        resolve({ module, startupTime: (performance.now() - start) / 1000 })
+      },
+    })
+  })
+}
+
+function median(values) {
+  const sorted = values.slice().sort((a, b) => a - b)
+  const middle = Math.floor(sorted.length / 2)
+
+  return sorted.length % 2
+    ? sorted[middle]
+    : (sorted[middle - 1] + sorted[middle]) / 2
+}
+
+async function runCase(build, input, preset, runs) {
+  const { module, startupTime } = await loadModule(build)
+  const wallTimes = []
+  const fpsValues = []
+  let outputSize = 0
+  let stats = null
+
+  for (let run = 0; run < runs; run++) {
+    let progress = null
+
+    const start = performance.now()
+    const output = module.convert(new Uint8Array(input.data), {
+      ...preset,
+      verbose: false,
+      onProgress: current => {
+        progress = current
+      },
+    })
+    const end = performance.now()
+
+    wallTimes.push((end - start) / 1000)
+    fpsValues.push(progress ? progress.fps : 0)
+    outputSize = output.byteLength
+    stats = module.getStats()
+  }
+
+  return {
+    build,
+    input: input.name,
+    ...preset,
+    codeSize: getCodeSize(build),
+    startupTime,
+    wallTime: median(wallTimes),
+    fps: median(fpsValues),
+    peakHeap: stats ? stats.peakHeap : 0,
+    outputSize,
+    stats,
+  }
+}
+
+const SEGMENT_COUNT = 3
+
+// Preset of the segments, which are matroska until they're joined
+const SEGMENT_PRESET = {
+  outputFormat: 'mp4',
+  videoEncoder: 'libx264',
+  audioEncoder: 'aac',
+}
+
+// Converts the input whole and in segments joined back together, and returns
+// what differs between the two. A segment placed after a gap moves its
+// keyframe away from its cut, one whose headers don't match the first one
+// doesn't decode, and the audio priming of every segment shows in its length.
+async function checkSegments(build, input) {
+  const { module } = await loadModule(build)
+  const data = new Uint8Array(input.data)
+  const cuts = module.planSegments(data, SEGMENT_COUNT)
+  const problems = []
+
+  if (!cuts.length) {
+    return [`${input.name} can't be split`]
+  }
+
+  const segments = [...cuts, undefined].map((endTime, index) =>
+    module.convert(data, {
+      ...SEGMENT_PRESET,
+      outputFormat: 'matroska',
+      startTime: index > 0 ? cuts[index - 1] : undefined,
+      endTime,
+    })
+  )
+  const joined = module.concat(segments, cuts, SEGMENT_PRESET)
+
+  // decoding both whole also counts their frames
+  const countFrames = source => {
+    let frames = 0
+
+    module.convert(source, {
+      ...SEGMENT_PRESET,
+      preset: 'ultrafast',
+      onProgress: progress => {
+        frames = progress.frames
+      },
+    })
+
+    return frames
+  }
+
+  const inputFrames = countFrames(data)
+  const joinedFrames = countFrames(joined)
+
+  if (joinedFrames !== inputFrames) {
+    problems.push(`${joinedFrames} frames joined, ${inputFrames} in the input`)
+  }
+
+  const inputInfo = module.probe(data, { keyframes: 'none' })
+  const joinedInfo = module.probe(joined, { keyframes: 'scan' })
+  const video = inputInfo.streams[inputInfo.videoStream]
+  const frameTime = 1 / (video.frameRate || 25)
+  const start = inputInfo.startTime > 0 ? inputInfo.startTime : 0
+
+  for (const cut of cuts) {
+    const placed = joinedInfo.keyframes.some(
+      time => Math.abs(time - (cut - start)) < frameTime
+    )
+
+    if (!placed) {
+      problems.push(`no keyframe at the cut at ${cut}s`)
+    }
+  }
+
+  // a frame of slack for the video, and an aac frame of priming per segment
+  const tolerance = frameTime + (SEGMENT_COUNT * 1024) / 44100
+
+  if (Math.abs(joinedInfo.duration - inputInfo.duration) > tolerance) {
+    problems.push(
+      `${joinedInfo.duration}s joined, ${inputInfo.duration}s in the input`
+    )
+  }
+
+  if (inputInfo.audioStream !== null && joinedInfo.audioStream !== null) {
+    const inputAudio = inputInfo.streams[inputInfo.audioStream].duration
+    const joinedAudio = joinedInfo.streams[joinedInfo.audioStream].duration
+
+    if (Math.abs(joinedAudio - inputAudio) > tolerance) {
+      problems.push(
+        `${joinedAudio}s of audio joined, ${inputAudio}s in the input`
+      )
+    }
+  }
+
+  return problems
+}
+
+const getCaseKey = result =>
+  [
+    result.build,
+    result.input,
+    result.outputFormat,
+    result.videoEncoder,
+    result.audioEncoder,
+  ].join('/')
+
+function findRegressions(results, baseline) {
+  const baselineResults = new Map(
+    baseline.results.map(result => [getCaseKey(result), result])
+  )
+  const regressions = []
+
+  for (const result of results) {
+    const previous = baselineResults.get(getCaseKey(result))
+
+    if (!previous) {
+      continue
+    }
+
+    for (const metric of Object.keys(THRESHOLDS)) {
+      if (!previous[metric]) {
+        continue
+      }
+
+      const change = (result[metric] - previous[metric]) / previous[metric]
+      const regression = LOWER_IS_BETTER.includes(metric) ? change : -change
+
+      if (regression > THRESHOLDS[metric]) {
+        regressions.push({
+          case: getCaseKey(result),
+          metric,
+          baseline: previous[metric],
+          value: result[metric],
+          change,
+        })
+      }
+    }
+  }
+
+  return regressions
+}
+
+// Only builds the manifest already lists are updated, the site has no use for
+// the others. A rebuild replaces the entry and drops the measurement with it.
+function updateManifest(results) {
+  const manifest = JSON.parse(fs.readFileSync(MANIFEST_PATH, 'utf8'))
+
+  for (const result of results) {
+    const entry = manifest.builds[MANIFEST_BUILDS[result.build]]
+
+    if (!entry || !isReferenceCase(result)) {
+      continue
+    }
+
+    entry.fps = result.fps
+  }
+
+  fs.writeFileSync(MANIFEST_PATH, JSON.stringify(manifest, null, 2) + '\n')
+}
+
+function isReferenceCase(result) {
+  return Object.keys(REFERENCE_CASE).every(
+    key => result[key] === REFERENCE_CASE[key]
+  )
+}
+
+function formatSize(bytes) {
+  return `${(bytes / 1024 / 1024).toFixed(2)} MiB`
+}
+
+// The benchmark builds target node and have a few more decoders than the ones
+// the site loads, so their sizes are only comparable between each other.
+function updateReadme(results) {
+  const rows = results
+    .filter(isReferenceCase)
+    .map(
+      result =>
+        `| ${result.build} | ${formatSize(result.codeSize)} | ` +
+        `${result.startupTime.toFixed(2)}s | ${result.fps.toFixed(1)} |`
+    )
+
+  if (!rows.length) {
+    console.error('No build ran the reference case, the README is unchanged')
+    return
+  }
+
+  const table = [
+    `Measured on node ${process.version}, ${os.cpus()[0].model}, ` +
+      `${new Date().toISOString().slice(0, 10)}:`,
+    '',
+    '| Build | Code size | Startup | fps |',
+    '| --- | --- | --- | --- |',
+    ...rows,
+  ].join('\n')
+
+  const readme = fs.readFileSync(README_PATH, 'utf8')
+  const start = readme.indexOf(README_TABLE_START)
+  const end = readme.indexOf(README_TABLE_END)
+
+  if (start === -1 || end < start) {
+    throw new Error(`README.md has no ${README_TABLE_START} section`)
+  }
+
+  fs.writeFileSync(
+    README_PATH,
+    readme.slice(0, start + README_TABLE_START.length) +
+      `\n\n${table}\n\n` +
+      readme.slice(end)
+  )
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2))
+  const inputs = getInputs()
+  const results = []
+
+  for (const build of args.builds) {
+    if (!BUILDS[build]) {
+      throw new Error(`Unknown build '${build}'`)
+    }
+
+    if (!fs.existsSync(BUILDS[build])) {
+      console.error(`Skipping the ${build} build, it wasn't compiled`)
+      continue
+    }
+
+    for (const input of inputs) {
+      for (const preset of PRESETS) {
+        try {
+          const result = await runCase(build, input, preset, args.runs)
+
+          console.error(
+            `${getCaseKey(result)}: ${result.wallTime.toFixed(2)}s, ` +
+              `${result.fps.toFixed(1)} fps`
+          )
+
+          results.push(result)
+        } catch (err) {
+          // e.g. an audio only input to a muxer without audio streams
+          console.error(
+            `${[build, input.name, preset.outputFormat].join('/')}: ${err}`
+          )
+        }
+      }
+    }
+  }
+
+  const segmentProblems = []
+
+  if (args.checkSegments) {
+    const [earth] = inputs
+
+    for (const build of args.builds) {
+      // segments are only converted on the wasm builds
+      if (build === 'asm' || !fs.existsSync(BUILDS[build])) {
+        continue
+      }
+
+      for (const problem of await checkSegments(build, earth)) {
+        console.error(`${build}/${earth.name} segments: ${problem}`)
+        segmentProblems.push({ build, input: earth.name, problem })
+      }
+    }
+  }
+
+  const baseline =
+    args.baseline && !args.saveBaseline && fs.existsSync(args.baseline)
+      ? JSON.parse(fs.readFileSync(args.baseline, 'utf8'))
+      : null
+
+  const report = {
+    date: new Date().toISOString(),
+    node: process.version,
+    cpus: os.cpus().length,
+    runs: args.runs,
+    thresholds: THRESHOLDS,
+    results,
+    regressions: baseline ? findRegressions(results, baseline) : [],
+    segmentProblems,
+  }
+
+  const json = JSON.stringify(report, null, 2)
+
+  if (args.output) {
+    fs.writeFileSync(args.output, json)
+  } else {
+    console.log(json)
+  }
+
+  if (args.saveBaseline) {
+    fs.writeFileSync(args.baseline, json)
+  }
+
+  if (args.updateManifest) {
+    updateManifest(results)
+  }
+
+  if (args.updateReadme) {
+    updateReadme(results)
+  }
+
+  if (report.regressions.length) {
+    console.error(`${report.regressions.length} regression(s) found`)
+  }
+
+  if (segmentProblems.length) {
+    console.error(`${segmentProblems.length} problem(s) joining segments`)
+  }
+
+  if (report.regressions.length || segmentProblems.length) {
+    process.exit(1)
+  }
+}
+
+main()
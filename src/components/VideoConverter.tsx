@@ -8,13 +8,16 @@ import {
   Subtitle1,
 } from '@lucasecdb/rmdc'
 import classNames from 'classnames'
-import React, { useEffect, useState } from 'react'
+import React, { useEffect, useRef, useState } from 'react'
 
 import VideoPlayer from './VideoPlayer'
 import {
   Codec,
+  Metric,
   Muxer,
+  Progress,
   convert,
+  convertSegmented,
   listEncoders,
   listMuxers,
   retrieveMetrics,
@@ -41,6 +44,12 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
   const [skipDownload, setSkipDownload] = useState(false)
   const [batchMode, setBatchMode] = useState(false)
   const [batchNumber, setBatchNumber] = useState(1)
+  const [parallelBatch, setParallelBatch] = useState(false)
+  const [segmented, setSegmented] = useState(false)
+  const [streamCopy, setStreamCopy] = useState(false)
+  const [cacheResults, setCacheResults] = useState(false)
+  const [progress, setProgress] = useState<Progress | null>(null)
+  const abortControllerRef = useRef<AbortController | null>(null)
 
   const [selectedFormat, setSelectedFormat] = useState<string>('matroska')
   const [selectedVideoCodec, setSelectedVideoCodec] = useState<string>('mpeg4')
@@ -64,6 +73,22 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
     setBatchMode(prevBatchMode => !prevBatchMode)
   }
 
+  const handleParallelBatchToggle = () => {
+    setParallelBatch(prevParallel => !prevParallel)
+  }
+
+  const handleStreamCopyToggle = () => {
+    setStreamCopy(prevStreamCopy => !prevStreamCopy)
+  }
+
+  const handleCacheResultsToggle = () => {
+    setCacheResults(prevCacheResults => !prevCacheResults)
+  }
+
+  const handleSegmentedToggle = () => {
+    setSegmented(prevSegmented => !prevSegmented)
+  }
+
   const handleBatchNumberChange = (
     evt: React.ChangeEvent<HTMLInputElement>
   ) => {
@@ -94,11 +119,35 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
     ? audioCodecs.find(codec => codec.name === selectedAudioCodec)
     : null
 
+  // the muxer can't hold what this encoder produces
+  const isIncompatible = (codec: Codec) =>
+    !!format && !format.encoders.includes(codec.name)
+
   const handleMetricsDownload = async () => {
     const metrics = await retrieveMetrics()
 
     const header =
-      'filename,elapsed_time,input_size,output_size,format,video_codec,audio_codec,wasm,index'
+      'filename,elapsed_time,input_size,output_size,format,video_codec,audio_codec,wasm,index,' +
+      'concurrency,cached,cache_hits,cache_misses,' +
+      'demux_time,decode_time,filter_time,encode_time,mux_time,' +
+      'packets_read,packets_written,frames_decoded,frames_encoded,bytes_read,peak_heap'
+
+    const statsColumns = (stats: Metric['stats']) =>
+      stats
+        ? [
+            stats.demuxTime,
+            stats.decodeTime,
+            stats.filterTime,
+            stats.encodeTime,
+            stats.muxTime,
+            stats.packetsRead,
+            stats.packetsWritten,
+            stats.framesDecoded,
+            stats.framesEncoded,
+            stats.bytesRead,
+            stats.peakHeap,
+          ].join(',')
+        : ',,,,,,,,,,'
 
     const body = metrics
       .map(
@@ -119,7 +168,17 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
           ',' +
           (metric.wasm ? 1 : 0) +
           ',' +
-          metric.index
+          metric.index +
+          ',' +
+          metric.concurrency +
+          ',' +
+          (metric.cached ? 1 : 0) +
+          ',' +
+          metric.cacheHits +
+          ',' +
+          metric.cacheMisses +
+          ',' +
+          statsColumns(metric.stats)
       )
       .join('\n')
 
@@ -128,38 +187,77 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
     downloadFile('metrics.csv', csv)
   }
 
+  const handleCancel = () => {
+    if (abortControllerRef.current) {
+      abortControllerRef.current.abort()
+    }
+  }
+
   const handleConvert = async () => {
-    const videoArrayBuffer = await new Response(video).arrayBuffer()
+    const abortController = new AbortController()
+
+    abortControllerRef.current = abortController
 
     setConversionInProgress(true)
     setConvertedVideos(0)
+    setProgress(null)
 
-    if (batchMode) {
+    const options = {
+      signal: abortController.signal,
+      asm: asmEnabled,
+      verbose,
+      outputFormat: format.name,
+      videoEncoder: videoCodec.name,
+      audioEncoder: audioCodec.name,
+      streamCopy,
+      // a batch measures conversions, every run after the first one would be
+      // served from the cache otherwise
+      cache: cacheResults && !batchMode,
+    }
+
+    if (batchMode && parallelBatch) {
+      // the worker pool runs as many of these in parallel as there are cores
+      await Promise.all(
+        Array.from({ length: batchNumber - 1 }, () =>
+          convert(video, video.name, options).then(() =>
+            setConvertedVideos(prev => prev + 1)
+          )
+        )
+      )
+    } else if (batchMode) {
+      // one at a time, so the elapsed times compare with earlier runs
       for (let i = 0; i < batchNumber - 1; i++) {
-        // eslint-disable-next-line no-await-in-loop
-        await convert(videoArrayBuffer, video.name, {
-          asm: asmEnabled,
-          verbose,
-          outputFormat: format.name,
-          videoEncoder: videoCodec.name,
-          audioEncoder: audioCodec.name,
-        })
+        if (abortController.signal.aborted) {
+          break
+        }
 
+        await convert(video, video.name, options)
         setConvertedVideos(prev => prev + 1)
       }
     }
 
-    const convertedVideoBuffer = await convert(videoArrayBuffer, video.name, {
-      asm: asmEnabled,
-      verbose,
-      outputFormat: format.name,
-      videoEncoder: videoCodec.name,
-      audioEncoder: audioCodec.name,
-    })
+    // only the last conversion reports its progress, the batch ones would
+    // just overwrite each other
+    const finalOptions = { ...options, onProgress: setProgress }
+
+    let convertedVideo: ArrayBuffer | null
+
+    if (abortController.signal.aborted) {
+      convertedVideo = null
+    } else if (segmented && !asmEnabled) {
+      convertedVideo = await convertSegmented(video, video.name, finalOptions)
+    } else {
+      // the download waits for the whole file anyway, so it's muxed in one
+      // piece to keep its duration and index (convertStream would fragment it)
+      convertedVideo = await convert(video, video.name, finalOptions)
+    }
+
+    abortControllerRef.current = null
 
     setConversionInProgress(false)
+    setProgress(null)
 
-    if (convertedVideoBuffer === null || !convertedVideoBuffer.byteLength) {
+    if (convertedVideo === null || !convertedVideo.byteLength) {
       return
     }
 
@@ -177,7 +275,7 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
       ? `${filenameWithoutExtension}.${defaultExtension}`
       : filenameWithoutExtension
 
-    downloadFile(outputFilename, convertedVideoBuffer)
+    downloadFile(outputFilename, convertedVideo)
   }
 
   useEffect(() => {
@@ -253,7 +351,11 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
               onChange={evt => setSelectedVideoCodec(evt.target.value)}
             >
               {videoCodecs.map(codec => (
-                <option key={codec.id} value={codec.name}>
+                <option
+                  key={codec.id}
+                  value={codec.name}
+                  disabled={isIncompatible(codec)}
+                >
                   {codec.longName}
                 </option>
               ))}
@@ -267,7 +369,11 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
               onChange={evt => setSelectedAudioCodec(evt.target.value)}
             >
               {audioCodecs.map(codec => (
-                <option key={codec.id} value={codec.name}>
+                <option
+                  key={codec.id}
+                  value={codec.name}
+                  disabled={isIncompatible(codec)}
+                >
                   {codec.longName}
                 </option>
               ))}
@@ -339,6 +445,62 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
               )}
             </div>
 
+            {batchMode && (
+              <FormField
+                input={
+                  <Checkbox
+                    nativeControlId="parallelBatch"
+                    name="parallelBatch"
+                    onChange={handleParallelBatchToggle}
+                    checked={parallelBatch}
+                  />
+                }
+                label={<span>Run the batch in parallel</span>}
+                inputId="parallelBatch"
+              />
+            )}
+
+            <FormField
+              input={
+                <Checkbox
+                  nativeControlId="streamCopy"
+                  name="streamCopy"
+                  onChange={handleStreamCopyToggle}
+                  checked={streamCopy}
+                />
+              }
+              label={<span>Copy streams that already match the codec</span>}
+              inputId="streamCopy"
+            />
+
+            <FormField
+              input={
+                <Checkbox
+                  nativeControlId="cacheResults"
+                  name="cacheResults"
+                  onChange={handleCacheResultsToggle}
+                  checked={cacheResults}
+                  disabled={batchMode}
+                />
+              }
+              label={<span>Reuse the result of earlier conversions</span>}
+              inputId="cacheResults"
+            />
+
+            <FormField
+              input={
+                <Checkbox
+                  nativeControlId="segmented"
+                  name="segmented"
+                  onChange={handleSegmentedToggle}
+                  checked={segmented}
+                  disabled={asmEnabled}
+                />
+              }
+              label={<span>Split into parallel segments</span>}
+              inputId="segmented"
+            />
+
             <FormField
               input={
                 <Checkbox
@@ -395,6 +557,24 @@ const VideoConverter: React.FC<Props> = ({ video, onClose }) => {
           'Convert'
         )}
       </Button>
+      {conversionInProgress && (
+        <div className="flex items-center self-center mt2">
+          {progress && (
+            <Caption className="mr2">
+              {progress.duration
+                ? Math.min(
+                    100,
+                    Math.round((progress.time / progress.duration) * 100)
+                  ) + '% · '
+                : ''}
+              {progress.fps.toFixed(1)} fps
+            </Caption>
+          )}
+          <Button dense type="button" onClick={handleCancel}>
+            Cancel
+          </Button>
+        </div>
+      )}
     </div>
   )
 }
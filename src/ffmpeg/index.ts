@@ -1,48 +1,187 @@
-import { wrap } from 'comlink'
+import { proxy, transfer, wrap } from 'comlink'
+
+import wasmUrl from '../../lib/ffmpeg/convert.wasm'
+import { WorkerPool } from './pool'
+import { getCacheCounters, getCacheKey, withCache } from './result-cache'
+import {
+  BuildVariant,
+  MAX_CODEC_THREADS,
+  compileModule,
+  getBuildInfo,
+  importBuildFile,
+  isAbortError,
+  selectBuildVariant,
+  supportsSharedMemory,
+} from './util'
 
 type WorkerAPI = import('./worker').WorkerAPI
 type ConvertOptions = import('./worker').ConvertOptions
+type MultiConvertOptions = import('./worker').MultiConvertOptions
+type InputData = import('./worker').InputData
 
 export type Codec = import('./worker').Codec
 export type Muxer = import('./worker').Muxer
+export type Capabilities = import('./worker').Capabilities
 
-type Metric = import('./worker').Metric
+type WorkerMetric = import('./worker').Metric
 type FileRuntimeMap = import('./worker').FileRuntimeMap
+type ChunkCallback = import('./worker').ChunkCallback
+type ProgressCallback = import('./worker').ProgressCallback
+type JobStats = import('./worker').JobStats
+
+export type Progress = import('./worker').Progress
+export type ProbeInfo = import('./worker').ProbeInfo
+type ProbeOptions = import('./worker').ProbeOptions
+export type Thumbnail = import('./worker').Thumbnail
+type ThumbnailOptions = import('./worker').ThumbnailOptions
 
 interface Options extends ConvertOptions {
   asm?: boolean
+  onProgress?: ProgressCallback
+  // aborting it cancels the conversion
+  signal?: AbortSignal
+  // whether `convert` may serve the output of an identical earlier
+  // conversion. The input is hashed whole before converting, so it's only on
+  // by default for inputs already in memory, not for a Blob or File.
+  cache?: boolean
+}
+
+export interface Metric extends WorkerMetric {
+  // most conversions that ran at once during this one, itself included. Its
+  // elapsed time only compares with runs at the same concurrency.
+  concurrency: number
+  // served from the cache of results instead of converted
+  cached: boolean
+  // hits and misses of the cache so far
+  cacheHits: number
+  cacheMisses: number
 }
 
 const fileRunMap: FileRuntimeMap = {}
 const runtimeMetrics: Metric[] = []
 
-const getAPI = (() => {
-  let worker: Worker
-  let workerAPI: Promise<WorkerAPI>
+// Conversions in flight, each with the most that ran alongside it so far
+const runningJobs = new Set<{ concurrency: number }>()
 
-  return async (reset = false) => {
-    if (!worker || reset) {
-      if (worker && reset) {
-        worker.terminate()
-      }
+// Counts a conversion as running until the returned function is called, which
+// gives its concurrency
+const startJob = () => {
+  const job = { concurrency: 0 }
+
+  runningJobs.add(job)
+  runningJobs.forEach(running => {
+    running.concurrency = Math.max(running.concurrency, runningJobs.size)
+  })
+
+  return () => {
+    runningJobs.delete(job)
+    return job.concurrency
+  }
+}
+
+const recordMetrics = (
+  metrics: WorkerMetric,
+  concurrency: number,
+  cached = false
+) => {
+  const { hits, misses } = getCacheCounters()
+
+  runtimeMetrics.push({
+    ...metrics,
+    concurrency,
+    cached,
+    cacheHits: hits,
+    cacheMisses: misses,
+  })
+}
+
+// The build a job runs on and the hash it was built with, for the cache key
+const getBuildId = (asm?: boolean) => {
+  const variant = asm ? 'asm' : selectBuildVariant()
+  const buildInfo = getBuildInfo(variant)
+
+  return `${variant}:${buildInfo ? buildInfo.hash : ''}`
+}
+
+const getInputSize = (inputData: InputData) =>
+  inputData instanceof Blob ? inputData.size : inputData.byteLength
+
+// The optional builds are only in the bundle when they were compiled
+const getWasmUrl = (variant: BuildVariant): Promise<string> =>
+  variant === 'default'
+    ? Promise.resolve(wasmUrl)
+    : importBuildFile(variant, 'convert.wasm').then(file => file.default)
+
+let precompiledModule: WebAssembly.Module | undefined
 
-      worker = new Worker('./worker', { name: 'ffmpeg-worker', type: 'module' })
-      const FFmpeg = wrap<WorkerAPI>(worker)
-      // @ts-ignore
-      workerAPI = new FFmpeg()
+// Compiled once on the main thread and handed to every worker, which only
+// has to instantiate it
+const getCompiledModule = (() => {
+  let compiledModule: Promise<WebAssembly.Module | undefined>
+
+  return () => {
+    if (!compiledModule) {
+      compiledModule = precompiledModule
+        ? Promise.resolve(precompiledModule)
+        : getWasmUrl(selectBuildVariant())
+            .then(compileModule)
+            .catch(err => {
+              // the workers can still compile it on their own
+              console.error(err)
+              return undefined
+            })
     }
 
-    return workerAPI
+    return compiledModule
   }
 })()
 
-export async function convert(
-  inputData: ArrayBuffer,
-  filename: string,
-  { asm = false, ...opts }: Options
-) {
-  const api = await getAPI(true)
+/**
+ * Starts compiling the module of the selected build ahead of the first job,
+ * or hands over one the page already compiled (which must come from the same
+ * build). Only has an effect before the first call to it or to a conversion.
+ */
+export function preloadModule(compiledModule?: WebAssembly.Module) {
+  precompiledModule = compiledModule
+  return getCompiledModule().then(() => undefined)
+}
+
+// With the pthreads build every worker already keeps a few cores busy
+const getPoolSize = () => {
+  const cores = navigator.hardwareConcurrency || 1
+
+  return selectBuildVariant() === 'threads'
+    ? Math.max(1, Math.floor(cores / MAX_CODEC_THREADS))
+    : cores
+}
+
+const getPool = (() => {
+  let pool: WorkerPool<WorkerAPI>
 
+  return () => {
+    if (!pool) {
+      pool = new WorkerPool<WorkerAPI>(() => {
+        const worker = new Worker('./worker', {
+          name: 'ffmpeg-worker',
+          type: 'module',
+        })
+        const FFmpeg = wrap<WorkerAPI>(worker)
+
+        return {
+          api: getCompiledModule().then(
+            // @ts-ignore
+            compiledModule => new FFmpeg(compiledModule)
+          ),
+          terminate: () => worker.terminate(),
+        }
+      }, getPoolSize())
+    }
+
+    return pool
+  }
+})()
+
+const getRunInfo = (filename: string) => {
   if (!fileRunMap[filename]) {
     fileRunMap[filename] = {
       wasm: 0,
@@ -50,38 +189,419 @@ export async function convert(
     }
   }
 
-  if (asm) {
-    const id = ++fileRunMap[filename].asm
-    const { data, metrics } = await api.convertAsm(
-      id,
-      inputData,
-      filename,
-      opts
+  return fileRunMap[filename]
+}
+
+// Stage times of jobs that ran in parallel add up to the total time spent in
+// each stage, while the heap peaks of separate workers don't add up
+const mergeStats = (stats: Array<JobStats | null>) =>
+  stats.reduce<JobStats | null>((merged, current) => {
+    if (!merged || !current) {
+      return merged || current
+    }
+
+    const result = { ...merged }
+
+    for (const key of Object.keys(current) as Array<keyof JobStats>) {
+      // the job's preset isn't a quantity, it's set on the merged stats
+      if (key === 'preset') {
+        continue
+      }
+
+      result[key] =
+        key === 'peakHeap'
+          ? Math.max(merged[key], current[key])
+          : merged[key] + current[key]
+    }
+
+    return result
+  }, null)
+
+/**
+ * A worker is blocked for as long as its job runs, so it's cancelled through
+ * a flag in shared memory that the module polls while converting. Without
+ * shared memory the signal is handed to the pool instead, which terminates
+ * the worker.
+ */
+const createCancellation = (signal?: AbortSignal) => {
+  if (!signal || !supportsSharedMemory()) {
+    return { cancelFlag: undefined, poolSignal: signal }
+  }
+
+  const cancelFlag = new Int32Array(new SharedArrayBuffer(4))
+  const cancel = () => Atomics.store(cancelFlag, 0, 1)
+
+  if (signal.aborted) {
+    cancel()
+  } else {
+    signal.addEventListener('abort', cancel)
+  }
+
+  return { cancelFlag, poolSignal: undefined }
+}
+
+async function runConversion(
+  inputData: InputData,
+  filename: string,
+  { asm = false, onProgress, signal, cache, ...opts }: Options,
+  onChunk?: ChunkCallback
+) {
+  const chunkCallback = onChunk ? proxy(onChunk) : undefined
+  const progressCallback = onProgress ? proxy(onProgress) : undefined
+  const { cancelFlag, poolSignal } = createCancellation(signal)
+  const runInfo = getRunInfo(filename)
+  const id = asm ? ++runInfo.asm : ++runInfo.wasm
+
+  const finishJob = startJob()
+
+  try {
+    const result = await getPool().run(
+      api =>
+        (asm ? api.convertAsm : api.convert)(
+          id,
+          inputData,
+          filename,
+          opts,
+          chunkCallback,
+          progressCallback,
+          cancelFlag
+        ),
+      poolSignal
     )
+    const concurrency = finishJob()
+
+    if (result.metrics) {
+      recordMetrics(result.metrics, concurrency)
+    }
 
-    runtimeMetrics.push(metrics)
+    return result
+  } catch (err) {
+    finishJob()
+
+    if (isAbortError(err)) {
+      return { data: null, metrics: null }
+    }
+
+    throw err
+  }
+}
+
+/**
+ * Converts the input, or resolves right away to the output of an earlier
+ * conversion of the same bytes with the same options.
+ */
+export async function convert(
+  inputData: InputData,
+  filename: string,
+  { cache = !(inputData instanceof Blob), ...opts }: Options
+) {
+  const start = performance.now()
+  const key = cache
+    ? await getCacheKey(inputData, opts, getBuildId(opts.asm))
+    : null
+
+  if (!key) {
+    const { data } = await runConversion(inputData, filename, opts)
 
     return data
   }
 
-  const id = ++fileRunMap[filename].wasm
-  const { data, metrics } = await api.convert(id, inputData, filename, opts)
+  const { data, hit } = await withCache(key, () =>
+    runConversion(inputData, filename, opts).then(result => result.data)
+  )
 
-  runtimeMetrics.push(metrics)
+  if (data && hit) {
+    const runInfo = getRunInfo(filename)
+
+    recordMetrics(
+      {
+        elapsedTime: (performance.now() - start) / 1000,
+        file: filename,
+        inputSize: getInputSize(inputData),
+        outputSize: data.byteLength,
+        format: opts.outputFormat,
+        videoCodec: opts.videoEncoder,
+        audioCodec: opts.audioEncoder,
+        wasm: !opts.asm,
+        index: opts.asm ? ++runInfo.asm : ++runInfo.wasm,
+        stats: null,
+      },
+      // the conversions it was served alongside
+      runningJobs.size + 1,
+      true
+    )
+  }
 
   return data
 }
 
-export async function listEncoders() {
-  const api = await getAPI()
+/**
+ * Same as `convert`, but the output is handed to `onChunk` while it's being
+ * muxed instead of all at once in the end. Resolves to whether the conversion
+ * succeeded. Only worth it where the chunks are consumed as they come, e.g.
+ * by MediaSource or an upload: matroska/webm outputs lose their duration and
+ * cues, and mp4/mov ones are fragmented.
+ */
+export async function convertStream(
+  inputData: InputData,
+  filename: string,
+  opts: Options,
+  onChunk: ChunkCallback
+) {
+  const { metrics } = await runConversion(inputData, filename, opts, onChunk)
 
-  return api.listEncoders()
+  return !!metrics
 }
 
-export async function listMuxers() {
-  const api = await getAPI()
+/**
+ * Converts the input to several outputs at once, e.g. the renditions of an
+ * adaptive bitrate ladder, decoding it only once. Only runs on the wasm build.
+ * Resolves to the outputs in the order of `opts.outputs`, or to null when the
+ * conversion failed.
+ */
+export async function convertMany(
+  inputData: InputData,
+  filename: string,
+  {
+    onProgress,
+    signal,
+    ...opts
+  }: MultiConvertOptions & Pick<Options, 'onProgress' | 'signal'>
+) {
+  const progressCallback = onProgress ? proxy(onProgress) : undefined
+  const { cancelFlag, poolSignal } = createCancellation(signal)
+  const id = ++getRunInfo(filename).wasm
+
+  const finishJob = startJob()
+
+  try {
+    const result = await getPool().run(
+      api =>
+        api.convertMany(
+          id,
+          inputData,
+          filename,
+          opts,
+          progressCallback,
+          cancelFlag
+        ),
+      poolSignal
+    )
+    const concurrency = finishJob()
+
+    if (result.metrics) {
+      recordMetrics(result.metrics, concurrency)
+    }
+
+    return result.data
+  } catch (err) {
+    finishJob()
 
-  return api.listMuxers()
+    if (isAbortError(err)) {
+      return null
+    }
+
+    throw err
+  }
+}
+
+/**
+ * Splits the input on keyframes, converts the segments in parallel on the
+ * worker pool and joins them back without re-encoding. Only runs on the wasm
+ * build, and falls back to `convert` when the input can't be split.
+ */
+export async function convertSegmented(
+  inputData: InputData,
+  filename: string,
+  { asm, onProgress, ...options }: Options
+) {
+  const { signal, cache, ...jobOpts } = options
+  const pool = getPool()
+  const start = performance.now()
+  // a Blob is posted to the workers by reference and each one only reads the
+  // slices of its segment, where a buffer would be cloned for every job
+  const segmentInput =
+    inputData instanceof Blob ? inputData : new Blob([inputData])
+  const cuts = await pool.run(api =>
+    api.planSegments(segmentInput, getPoolSize())
+  )
+
+  if (!cuts.length) {
+    return convert(inputData, filename, { asm, onProgress, ...options })
+  }
+
+  const { cancelFlag, poolSignal } = createCancellation(signal)
+  let opts = jobOpts
+
+  // The segments are joined without re-encoding, so they must all share one
+  // preset and size. Each one resolving 'auto' on its own could mix x264
+  // settings (and their global headers) in the same stream. The trial plans
+  // for a single encode of the whole range, which the parallel segments beat.
+  if (opts.preset === 'auto') {
+    const resolved = await pool.run(
+      api => api.resolvePreset(segmentInput, opts, cancelFlag),
+      poolSignal
+    )
+
+    if (!resolved) {
+      return null
+    }
+
+    opts = { ...opts, ...resolved }
+  }
+  const segmentProgress: Progress[] = []
+
+  // the segments report on their own, the job's progress adds them up
+  const reportSegmentProgress = (index: number, progress: Progress) => {
+    if (!onProgress) {
+      return
+    }
+
+    segmentProgress[index] = progress
+
+    const total = { packets: 0, frames: 0, time: 0, bytes: 0 }
+
+    segmentProgress.forEach((current, i) => {
+      total.packets += current.packets
+      total.frames += current.frames
+      // the time of a segment's progress is its position in the input
+      total.time += current.time - (i > 0 ? cuts[i - 1] : 0)
+      total.bytes += current.bytes
+    })
+
+    const elapsed = (performance.now() - start) / 1000
+
+    onProgress({
+      ...total,
+      duration: progress.duration,
+      fps: elapsed > 0 ? total.frames / elapsed : 0,
+    })
+  }
+
+  const id = ++getRunInfo(filename).wasm
+  const finishJob = startJob()
+  let data: ArrayBuffer | null
+  let stats: JobStats | null
+  let concurrency = 1
+
+  try {
+    // the segments share the codecs of the final output, matroska is only
+    // used because it can hold any of them until they're joined
+    const segments = await Promise.all(
+      [...cuts, undefined].map((endTime, index) =>
+        pool.run(
+          api =>
+            api.convert(
+              id,
+              segmentInput,
+              filename,
+              {
+                ...opts,
+                outputFormat: 'matroska',
+                startTime: index > 0 ? cuts[index - 1] : undefined,
+                endTime,
+              },
+              undefined,
+              onProgress
+                ? proxy((progress: Progress) =>
+                    reportSegmentProgress(index, progress)
+                  )
+                : undefined,
+              cancelFlag
+            ),
+          poolSignal
+        )
+      )
+    )
+
+    if (segments.some(segment => !segment.data)) {
+      return null
+    }
+
+    stats = mergeStats(
+      segments.map(segment => segment.metrics && segment.metrics.stats)
+    )
+
+    if (stats && jobOpts.preset === 'auto') {
+      stats.preset = opts.preset as JobStats['preset']
+    }
+
+    const segmentBuffers = segments.map(segment => segment.data as ArrayBuffer)
+
+    data = await pool.run(
+      api =>
+        api.concat(
+          transfer(segmentBuffers, segmentBuffers),
+          cuts,
+          opts,
+          cancelFlag
+        ),
+      poolSignal
+    )
+  } catch (err) {
+    if (isAbortError(err)) {
+      return null
+    }
+
+    throw err
+  } finally {
+    concurrency = finishJob()
+  }
+
+  const end = performance.now()
+
+  if (data) {
+    recordMetrics(
+      {
+        elapsedTime: (end - start) / 1000,
+        file: filename,
+        inputSize: getInputSize(inputData),
+        outputSize: data.byteLength,
+        format: opts.outputFormat,
+        videoCodec: opts.videoEncoder,
+        audioCodec: opts.audioEncoder,
+        wasm: true,
+        index: id,
+        stats,
+      },
+      concurrency
+    )
+  }
+
+  return data
+}
+
+/**
+ * Reads the container headers of the input, to decide how to convert it
+ * before committing to a full conversion. Resolves to null when the input
+ * can't be read.
+ */
+export async function probe(inputData: InputData, opts?: ProbeOptions) {
+  return getPool().run(api => api.probe(inputData, opts))
+}
+
+/**
+ * Still images of the input's video, decoding only a few frames around each
+ * requested time whatever the length of the input. Resolves to an empty list
+ * when the input has no video.
+ */
+export async function extractThumbnails(
+  inputData: InputData,
+  opts?: ThumbnailOptions
+) {
+  return getPool().run(api => api.thumbnails(inputData, opts))
+}
+
+export async function getCapabilities() {
+  return getPool().run(api => api.getCapabilities())
+}
+
+export async function listEncoders() {
+  return getPool().run(api => api.listEncoders())
+}
+
+export async function listMuxers() {
+  return getPool().run(api => api.listMuxers())
 }
 
 export async function retrieveMetrics() {
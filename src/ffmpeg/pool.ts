@@ -0,0 +1,162 @@
+import { isWorkerFailure } from './util'
+
+export interface PoolWorker<T> {
+  api: Promise<T>
+  terminate(): void
+}
+
+interface PoolEntry<T> extends PoolWorker<T> {
+  busy: boolean
+}
+
+const createAbortError = () => new DOMException('Aborted', 'AbortError')
+
+function abortable<R>(promise: Promise<R>, signal: AbortSignal) {
+  return new Promise<R>((resolve, reject) => {
+    const handleAbort = () => reject(createAbortError())
+
+    if (signal.aborted) {
+      handleAbort()
+      return
+    }
+
+    signal.addEventListener('abort', handleAbort)
+
+    promise.then(
+      value => {
+        signal.removeEventListener('abort', handleAbort)
+        resolve(value)
+      },
+      err => {
+        signal.removeEventListener('abort', handleAbort)
+        reject(err)
+      }
+    )
+  })
+}
+
+/**
+ * Keeps up to `size` long-lived workers around and hands them out to jobs
+ * one at a time, queueing jobs when all of them are busy.
+ */
+export class WorkerPool<T> {
+  private entries: Array<PoolEntry<T>> = []
+  private waiting: Array<{
+    resolve: (entry: PoolEntry<T>) => void
+    reject: (err: Error) => void
+  }> = []
+
+  constructor(
+    private createWorker: () => PoolWorker<T>,
+    private size: number
+  ) {}
+
+  /**
+   * Runs `task` on the next idle worker. Aborting `signal` rejects the task
+   * and terminates its worker, for tasks that can't be stopped otherwise.
+   */
+  public async run<R>(
+    task: (api: T) => Promise<R>,
+    signal?: AbortSignal
+  ): Promise<R> {
+    if (signal && signal.aborted) {
+      throw createAbortError()
+    }
+
+    const entry = await this.acquire()
+    let broken = false
+
+    try {
+      let api: T
+
+      try {
+        api = await entry.api
+      } catch (err) {
+        // the worker never started
+        broken = true
+        throw err
+      }
+
+      const result = task(api)
+
+      return await (signal ? abortable(result, signal) : result)
+    } catch (err) {
+      // A task abandoned through `signal` is still running in the worker, and
+      // a worker failure leaves nothing to reuse. A job that failed or was
+      // cancelled on its own leaves the worker ready for the next one.
+      if ((signal && signal.aborted) || isWorkerFailure(err)) {
+        broken = true
+      }
+
+      throw err
+    } finally {
+      this.release(entry, broken)
+    }
+  }
+
+  /**
+   * Terminates every worker. Tasks still queued for one are rejected with an
+   * AbortError, the running ones are left to the callers' signals.
+   */
+  public terminate() {
+    this.entries.forEach(entry => entry.terminate())
+    this.entries = []
+
+    const waiting = this.waiting
+
+    this.waiting = []
+    waiting.forEach(({ reject }) => reject(createAbortError()))
+  }
+
+  private acquireNow() {
+    const idle = this.entries.find(entry => !entry.busy)
+
+    if (idle) {
+      idle.busy = true
+      return idle
+    }
+
+    if (this.entries.length < this.size) {
+      const entry = { ...this.createWorker(), busy: true }
+      this.entries.push(entry)
+      return entry
+    }
+
+    return null
+  }
+
+  private acquire() {
+    const entry = this.acquireNow()
+
+    if (entry) {
+      return Promise.resolve(entry)
+    }
+
+    return new Promise<PoolEntry<T>>((resolve, reject) =>
+      this.waiting.push({ resolve, reject })
+    )
+  }
+
+  private release(entry: PoolEntry<T>, broken: boolean) {
+    const index = this.entries.indexOf(entry)
+
+    // the pool was terminated while the task ran
+    if (index < 0) {
+      return
+    }
+
+    if (broken) {
+      entry.terminate()
+      this.entries.splice(index, 1)
+    } else {
+      entry.busy = false
+    }
+
+    const next = this.waiting.shift()
+
+    if (next) {
+      // releasing always frees up a slot, so this can't be null
+      next.resolve(this.acquireNow()!)
+    }
+  }
+}
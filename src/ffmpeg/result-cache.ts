@@ -0,0 +1,337 @@
+type ConvertOptions = import('./worker').ConvertOptions
+type InputData = import('./worker').InputData
+
+const DB_NAME = 'convideo-results'
+// Outputs and their sizes are stored apart, so evicting doesn't have to read
+// back every output
+const DATA_STORE = 'results'
+const ENTRY_STORE = 'entries'
+
+// Bytes of outputs kept in each tier, the least recently used ones are
+// dropped beyond that
+const MEMORY_CACHE_SIZE = 256 * 1024 * 1024
+const PERSISTENT_CACHE_SIZE = 1024 * 1024 * 1024
+
+// The input is hashed a slice at a time, so a large File is never loaded
+// whole
+const HASH_CHUNK_SIZE = 16 * 1024 * 1024
+
+// Options that only change how a job runs, not its output
+const IGNORED_OPTIONS = [
+  'verbose',
+  'onProgress',
+  'progressInterval',
+  'memoryLimit',
+  'signal',
+]
+
+interface CacheEntry {
+  size: number
+  lastUsed: number
+}
+
+const memoryCache = new Map<string, ArrayBuffer>()
+let memoryCacheSize = 0
+
+const pendingConversions = new Map<string, Promise<ArrayBuffer | null>>()
+
+const counters = { hits: 0, misses: 0 }
+
+// A Blob can't change, so it's only hashed the first time it's converted
+const blobDigests = new WeakMap<Blob, Promise<string[]>>()
+
+export const getCacheCounters = () => ({ ...counters })
+
+const toHex = (digest: ArrayBuffer) =>
+  Array.from(new Uint8Array(digest), byte =>
+    byte.toString(16).padStart(2, '0')
+  ).join('')
+
+async function hashInput(input: InputData) {
+  const size = input instanceof Blob ? input.size : input.byteLength
+  const digests: string[] = []
+
+  for (let offset = 0; offset < size; offset += HASH_CHUNK_SIZE) {
+    const end = Math.min(offset + HASH_CHUNK_SIZE, size)
+    const chunk =
+      input instanceof Blob
+        ? await new Response(input.slice(offset, end)).arrayBuffer()
+        : new Uint8Array(input, offset, end - offset)
+
+    digests.push(toHex(await crypto.subtle.digest('SHA-256', chunk)))
+  }
+
+  return digests
+}
+
+/**
+ * The key of a conversion: a hash of the input bytes, of the options that
+ * affect the output and of the `build` converting it, since the encoders of
+ * each build may produce different bytes. Resolves to null where SubtleCrypto
+ * isn't available, i.e. outside of secure contexts, and for the auto preset,
+ * whose output depends on how fast the job ran.
+ */
+export async function getCacheKey(
+  input: InputData,
+  opts: Partial<ConvertOptions> & { asm?: boolean },
+  build: string
+) {
+  if (
+    typeof crypto === 'undefined' ||
+    !crypto.subtle ||
+    opts.preset === 'auto'
+  ) {
+    return null
+  }
+
+  let digests: Promise<string[]>
+
+  if (input instanceof Blob) {
+    const hashed = blobDigests.get(input) || hashInput(input)
+
+    // e.g. a File removed from the disk, hashing it is tried again next time
+    hashed.catch(() => blobDigests.delete(input))
+    blobDigests.set(input, hashed)
+    digests = hashed
+  } else {
+    digests = hashInput(input)
+  }
+
+  const normalizedOptions = Object.keys(opts)
+    .filter(key => !IGNORED_OPTIONS.includes(key))
+    .filter(key => (opts as any)[key] !== undefined)
+    .sort()
+    .map(key => [key, (opts as any)[key]])
+
+  const key = new TextEncoder().encode(
+    JSON.stringify([await digests, normalizedOptions, build])
+  )
+
+  return toHex(await crypto.subtle.digest('SHA-256', key))
+}
+
+function dropFromMemory(key: string) {
+  const data = memoryCache.get(key)
+
+  if (data) {
+    memoryCache.delete(key)
+    memoryCacheSize -= data.byteLength
+  }
+}
+
+function putInMemory(key: string, data: ArrayBuffer) {
+  if (data.byteLength > MEMORY_CACHE_SIZE) {
+    return
+  }
+
+  dropFromMemory(key)
+  memoryCache.set(key, data)
+  memoryCacheSize += data.byteLength
+
+  // a Map iterates in insertion order, so the first keys are the least
+  // recently used ones
+  const keys = Array.from(memoryCache.keys())
+
+  while (memoryCacheSize > MEMORY_CACHE_SIZE) {
+    dropFromMemory(keys.shift() as string)
+  }
+}
+
+function takeFromMemory(key: string) {
+  const data = memoryCache.get(key)
+
+  if (data) {
+    memoryCache.delete(key)
+    memoryCache.set(key, data)
+  }
+
+  return data
+}
+
+const openDatabase = (() => {
+  let database: Promise<IDBDatabase | undefined>
+
+  return () => {
+    if (!database) {
+      database = new Promise<IDBDatabase | undefined>(resolve => {
+        if (typeof indexedDB === 'undefined') {
+          resolve(undefined)
+          return
+        }
+
+        const request = indexedDB.open(DB_NAME, 1)
+
+        request.onupgradeneeded = () => {
+          request.result.createObjectStore(DATA_STORE)
+          request.result
+            .createObjectStore(ENTRY_STORE)
+            .createIndex('lastUsed', 'lastUsed')
+        }
+        request.onsuccess = () => resolve(request.result)
+        // e.g. private browsing, only the memory tier is used then
+        request.onerror = () => resolve(undefined)
+      })
+    }
+
+    return database
+  }
+})()
+
+function readPersisted(db: IDBDatabase, key: string) {
+  return new Promise<ArrayBuffer | undefined>((resolve, reject) => {
+    const transaction = db.transaction([DATA_STORE, ENTRY_STORE], 'readwrite')
+    const entries = transaction.objectStore(ENTRY_STORE)
+    const request = transaction.objectStore(DATA_STORE).get(key)
+
+    request.onsuccess = () => {
+      const data: ArrayBuffer | undefined = request.result
+
+      if (data) {
+        entries.put({ size: data.byteLength, lastUsed: Date.now() }, key)
+      }
+
+      resolve(data)
+    }
+    request.onerror = () => reject(request.error)
+  })
+}
+
+function writePersisted(db: IDBDatabase, key: string, data: ArrayBuffer) {
+  return new Promise<void>((resolve, reject) => {
+    const transaction = db.transaction([DATA_STORE, ENTRY_STORE], 'readwrite')
+    const results = transaction.objectStore(DATA_STORE)
+    const entries = transaction.objectStore(ENTRY_STORE)
+    const entry: CacheEntry = { size: data.byteLength, lastUsed: Date.now() }
+    let totalSize = 0
+
+    transaction.oncomplete = () => resolve()
+    transaction.onerror = () => reject(transaction.error)
+
+    results.put(data, key)
+    entries.put(entry, key)
+
+    // walks from the most recently used entry down, and drops everything past
+    // the size of the tier
+    const cursorRequest = entries.index('lastUsed').openCursor(null, 'prev')
+
+    cursorRequest.onsuccess = () => {
+      const cursor = cursorRequest.result
+
+      if (!cursor) {
+        return
+      }
+
+      totalSize += (cursor.value as CacheEntry).size
+
+      if (totalSize > PERSISTENT_CACHE_SIZE) {
+        results.delete(cursor.primaryKey)
+        cursor.delete()
+      }
+
+      cursor.continue()
+    }
+  })
+}
+
+// Looks the output of a conversion up in memory, then in IndexedDB
+async function readCachedResult(key: string) {
+  const data = takeFromMemory(key)
+
+  if (data) {
+    return data
+  }
+
+  const db = await openDatabase()
+  const persisted = db
+    ? await readPersisted(db, key).catch(() => undefined)
+    : undefined
+
+  if (persisted) {
+    putInMemory(key, persisted)
+  }
+
+  return persisted
+}
+
+async function writeCachedResult(key: string, data: ArrayBuffer) {
+  putInMemory(key, data)
+
+  const db = await openDatabase()
+
+  if (db) {
+    await writePersisted(db, key, data).catch(err => {
+      // e.g. over the storage quota, the memory tier still has it
+      console.error(err)
+    })
+  }
+}
+
+/**
+ * Serves the output of a conversion from the cache, or runs it and keeps what
+ * it resolves to. Identical conversions started while one is looked up or
+ * running wait for it instead of converting again. Every call counts as
+ * either a hit or a miss.
+ */
+export async function withCache(
+  key: string,
+  run: () => Promise<ArrayBuffer | null>
+): Promise<{ data: ArrayBuffer | null; hit: boolean }> {
+  const pending = pendingConversions.get(key)
+
+  if (pending) {
+    const data = await pending.catch(() => null)
+
+    if (!data) {
+      // a failed or cancelled run is retried by the calls that waited for it,
+      // which share the retry the same way
+      return withCache(key, run)
+    }
+
+    counters.hits++
+    // the caller owns what it gets, e.g. it may transfer it
+    return { data: data.slice(0), hit: true }
+  }
+
+  let converted = false
+
+  // registered before anything is awaited, so identical calls made in the
+  // meantime don't each read the cache, miss and convert on their own
+  const lookup = readCachedResult(key).then(cached => {
+    if (cached) {
+      return cached
+    }
+
+    converted = true
+    counters.misses++
+
+    return run().then(data => {
+      if (data) {
+        writeCachedResult(key, data)
+      }
+
+      return data
+    })
+  })
+  // done with before the callers waiting for it resume, so a retry of theirs
+  // starts over
+  const conversion = lookup.then(
+    data => {
+      pendingConversions.delete(key)
+      return data
+    },
+    err => {
+      pendingConversions.delete(key)
+      throw err
+    }
+  )
+
+  pendingConversions.set(key, conversion)
+
+  const data = await conversion
+
+  if (!converted) {
+    counters.hits++
+  }
+
+  return { data: data && data.slice(0), hit: !converted }
+}
@@ -1,15 +1,257 @@
+import manifest from '../../lib/ffmpeg/manifest.json'
+
 export type ModuleFactory<M extends EmscriptenModule> = (
   opts: Partial<EmscriptenModule>
 ) => M
 
+function compileFromBytes(url: string) {
+  return fetch(url)
+    .then(res => res.arrayBuffer())
+    .then(bytes => WebAssembly.compile(bytes))
+}
+
+/**
+ * Compiles the wasm binary while it downloads. Servers that don't send it as
+ * application/wasm make streaming compilation fail, so it then falls back to
+ * compiling the whole download. Later page loads are sped up by the browser's
+ * own code cache for the wasm URL.
+ */
+export function compileModule(url: string): Promise<WebAssembly.Module> {
+  if (typeof WebAssembly.compileStreaming !== 'function') {
+    return compileFromBytes(url)
+  }
+
+  return WebAssembly.compileStreaming(fetch(url)).catch(() =>
+    compileFromBytes(url)
+  )
+}
+
+// Must match MAX_CODEC_THREADS in lib/ffmpeg/convert.cpp
+export const MAX_CODEC_THREADS = 4
+
+/**
+ * Whether the pthreads build can run here. It needs shared wasm memory, which
+ * browsers only hand out to cross-origin isolated pages.
+ */
+export function supportsThreads() {
+  if (
+    typeof SharedArrayBuffer === 'undefined' ||
+    (self as any).crossOriginIsolated === false
+  ) {
+    return false
+  }
+
+  try {
+    const memory = new WebAssembly.Memory({
+      initial: 1,
+      maximum: 1,
+      shared: true,
+    } as WebAssembly.MemoryDescriptor)
+
+    return memory.buffer instanceof SharedArrayBuffer
+  } catch (err) {
+    return false
+  }
+}
+
+// Smallest module using a SIMD instruction, only valid where wasm SIMD is
+// supported (same check as wasm-feature-detect)
+const SIMD_TEST_MODULE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8,
+  0, 65, 0, 253, 15, 253, 98, 11,
+])
+
+export function supportsSimd() {
+  try {
+    return WebAssembly.validate(SIMD_TEST_MODULE)
+  } catch (err) {
+    return false
+  }
+}
+
+/**
+ * Whether shared memory can be posted to workers, which needs the same
+ * cross-origin isolation as the pthreads build.
+ */
+export function supportsSharedMemory() {
+  return (
+    typeof SharedArrayBuffer !== 'undefined' &&
+    (self as any).crossOriginIsolated !== false
+  )
+}
+
+export const isAbortError = (err: any) => !!err && err.name === 'AbortError'
+
+/**
+ * An error of the worker itself rather than of its job: its module couldn't
+ * be loaded, or the wasm runtime aborted. The pool replaces such a worker.
+ */
+export function createWorkerFailure(err: any) {
+  const failure = new Error(err instanceof Error ? err.message : String(err))
+  failure.name = 'WorkerFailure'
+  return failure
+}
+
+/**
+ * Whether the wasm runtime trapped or aborted, as opposed to a job failing
+ * with an error code. Older Emscripten versions abort by throwing a string.
+ */
+export const isRuntimeFailure = (err: any) =>
+  !!err &&
+  (err.name === 'RuntimeError' ||
+    (typeof err === 'string' && err.startsWith('abort(')))
+
+// The name survives being posted from the worker, unlike the error's class
+export const isWorkerFailure = (err: any) =>
+  !!err && (err.name === 'WorkerFailure' || isRuntimeFailure(err))
+
+export type BuildVariant = 'threads' | 'simd' | 'speed' | 'default'
+
+export interface BuildInfo {
+  profile: 'size' | 'speed'
+  hash: string | null
+  codeSize: number | null
+  jsSize: number | null
+  // what scripts/benchmark.js measured on its reference case, see
+  // `--update-manifest`
+  fps?: number
+}
+
+const builds: Partial<Record<BuildVariant | 'asm', BuildInfo>> =
+  manifest.builds as any
+
+/**
+ * What lib/ffmpeg/build.sh recorded about a build, or undefined when it
+ * wasn't built.
+ */
+export const getBuildInfo = (variant: BuildVariant | 'asm') => builds[variant]
+
+// build.sh adds a build to the manifest along with its hash once it's built
+const isBuilt = (variant: BuildVariant) => {
+  const info = builds[variant]
+
+  return !!info && info.hash != null
+}
+
+// A build only replaces the default one once the benchmark measured it
+// faster, its flags alone don't say it is in this runtime
+const isMeasuredFaster = (variant: BuildVariant) => {
+  const info = builds[variant]
+  const defaultInfo = builds.default
+
+  return (
+    !!info &&
+    !!defaultInfo &&
+    info.fps != null &&
+    defaultInfo.fps != null &&
+    info.fps > defaultInfo.fps
+  )
+}
+
+/**
+ * Picks the fastest build of ffmpeg this environment can run, out of the ones
+ * in lib/ffmpeg/manifest.json. Threads are preferred, since they scale with
+ * the number of cores. SIMD and then the speed profile replace the default
+ * build when the benchmark found them faster.
+ */
+export function selectBuildVariant(): BuildVariant {
+  if (supportsThreads() && isBuilt('threads')) {
+    return 'threads'
+  }
+
+  if (supportsSimd() && isBuilt('simd') && isMeasuredFaster('simd')) {
+    return 'simd'
+  }
+
+  if (isBuilt('speed') && isMeasuredFaster('speed')) {
+    return 'speed'
+  }
+
+  return 'default'
+}
+
+/**
+ * Loads a file of one of the optional builds, e.g. its `convert.wasm`. A
+ * direct import of a build that wasn't compiled fails the whole site build,
+ * so they go through a context of what the build's directory held when the
+ * site was built instead. Only builds in the manifest are ever asked for.
+ */
+export function importBuildFile(
+  variant: BuildVariant,
+  file: string
+): Promise<{ default: any }> {
+  switch (variant) {
+    case 'threads':
+      return import(
+        /* webpackInclude: /\.(js|wasm)$/ */
+        `../../lib/ffmpeg/threads/${file}`
+      )
+    case 'simd':
+      return import(
+        /* webpackInclude: /\.(js|wasm)$/ */
+        `../../lib/ffmpeg/simd/${file}`
+      )
+    case 'speed':
+      return import(
+        /* webpackInclude: /\.(js|wasm)$/ */
+        `../../lib/ffmpeg/speed/${file}`
+      )
+    default:
+      return Promise.reject(new Error(`The ${variant} build is bundled`))
+  }
+}
+
+interface ModuleUrls {
+  wasmUrl?: string
+  memUrl?: string
+  // pthread worker script of the threaded build
+  workerUrl?: string
+  // the threaded build's own script, which its pthread workers import again
+  mainScriptUrl?: string
+  wasmModule?: WebAssembly.Module
+}
+
 export function initEmscriptenModule<T extends EmscriptenModule>(
   moduleFactory: ModuleFactory<T>,
-  { wasmUrl, memUrl }: { wasmUrl?: string; memUrl?: string },
+  { wasmUrl, memUrl, workerUrl, mainScriptUrl, wasmModule }: ModuleUrls,
   opts: Partial<EmscriptenModule> = {}
 ): Promise<T> {
-  return new Promise(resolve => {
+  return new Promise((resolve, reject) => {
     const module = moduleFactory({
       ...opts,
+      ...(wasmModule && {
+        // Skip Emscripten's own fetch and compile when we were given an
+        // already compiled module.
+        instantiateWasm(
+          imports: WebAssembly.Imports,
+          successCallback: (
+            instance: WebAssembly.Instance,
+            module: WebAssembly.Module
+          ) => void
+        ) {
+          const instantiate = (compiled: WebAssembly.Module) =>
+            WebAssembly.instantiate(compiled, imports).then(instance =>
+              // the pthreads build shares the module with its threads
+              successCallback(instance, compiled)
+            )
+
+          instantiate(wasmModule)
+            .catch(err => {
+              // e.g. a module compiled from another build, whose imports
+              // don't match, so this build's own binary is compiled instead
+              if (!wasmUrl) {
+                throw err
+              }
+
+              return compileModule(wasmUrl).then(instantiate)
+            })
+            // e.g. out of memory, the runtime would otherwise wait forever
+            .catch(reject)
+
+          return {}
+        },
+      }),
+      ...(mainScriptUrl && { mainScriptUrlOrBlob: mainScriptUrl }),
       // Just to be safe, don't automatically invoke any wasm functions
       noInitialRun: true,
       locateFile(url: string): string {
@@ -20,8 +262,15 @@ export function initEmscriptenModule<T extends EmscriptenModule>(
         if (url.endsWith('.mem') && memUrl) {
           return memUrl
         }
+        if (url.endsWith('.worker.js') && workerUrl) {
+          return workerUrl
+        }
         return url
       },
+      // Emscripten's own fetch or instantiation failed
+      onAbort(what: any) {
+        reject(what instanceof Error ? what : new Error(String(what)))
+      },
       onRuntimeInitialized() {
         // An Emscripten is a then-able that resolves with itself, causing an infite loop when you
         // wrap it in a real promise. Delete the `then` prop solves this for now.
@@ -0,0 +1,33 @@
+type InputReader = import('../../../lib/ffmpeg/convert').InputReader
+
+// Bytes read from the blob at once. The demuxer asks for 64 KiB at a time, so
+// a slice serves several of its reads, and it's the only part of the input
+// held in memory.
+const WINDOW_SIZE = 1024 * 1024
+
+/**
+ * Reads a File or Blob in slices as the module asks for them, so a job starts
+ * as soon as the headers are in instead of after the whole file was loaded.
+ * A seek only moves where the next slice starts.
+ */
+export function createBlobReader(blob: Blob): InputReader {
+  const fileReader = new FileReaderSync()
+  let windowStart = 0
+  let window = new Uint8Array(0)
+
+  return {
+    size: blob.size,
+    read(offset: number, length: number) {
+      const end = Math.min(offset + length, blob.size)
+
+      if (offset < windowStart || end > windowStart + window.byteLength) {
+        const slice = blob.slice(offset, offset + Math.max(length, WINDOW_SIZE))
+
+        windowStart = offset
+        window = new Uint8Array(fileReader.readAsArrayBuffer(slice))
+      }
+
+      return window.subarray(offset - windowStart, end - windowStart)
+    },
+  }
+}
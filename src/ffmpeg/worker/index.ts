@@ -1,39 +1,37 @@
-import { expose } from 'comlink'
+import { expose, transfer } from 'comlink'
 
 import wasmUrl from '../../../lib/ffmpeg/convert.wasm'
 import memUrl from '../../../lib/ffmpeg/asm/convert.js.mem'
-import { ModuleFactory, initEmscriptenModule } from '../util'
+import {
+  ModuleFactory,
+  createWorkerFailure,
+  importBuildFile,
+  initEmscriptenModule,
+  isAbortError,
+  isRuntimeFailure,
+  selectBuildVariant,
+} from '../util'
+import { createBlobReader } from './blob-reader'
 
 type FFModule = import('../../../lib/ffmpeg/convert').FFModule
-export type ConvertOptions = import('../../../lib/ffmpeg/convert').ConvertOptions
-
-export interface Codec {
-  id: number
-  name: string
-  longName: string
-  capabilities: {
-    drawHorizBand: boolean
-    dr1: boolean
-    truncated: boolean
-    delay: boolean
-    subFrames: boolean
-    experimental: boolean
-    intraOnly: boolean
-    lossless: boolean
-    hardware: boolean
-    hybrid: boolean
-  }
-  type: number
-}
-
-export interface Muxer {
-  name: string
-  longName: string
-  mimeType: string
-  extensions: string[]
-  audioCodec?: number
-  videoCodec?: number
-}
+export type ConvertOptions = Omit<
+  import('../../../lib/ffmpeg/convert').ConvertOptions,
+  'onProgress'
+>
+export type MultiConvertOptions = Omit<
+  import('../../../lib/ffmpeg/convert').MultiConvertOptions,
+  'onProgress'
+>
+export type Progress = import('../../../lib/ffmpeg/convert').Progress
+export type JobStats = import('../../../lib/ffmpeg/convert').JobStats
+export type ProbeInfo = import('../../../lib/ffmpeg/convert').ProbeInfo
+export type ProbeOptions = import('../../../lib/ffmpeg/convert').ProbeOptions
+export type Thumbnail = import('../../../lib/ffmpeg/convert').Thumbnail
+export type ThumbnailOptions = import('../../../lib/ffmpeg/convert').ThumbnailOptions
+
+export type Codec = import('../../../lib/ffmpeg/convert').Codec
+export type Muxer = import('../../../lib/ffmpeg/convert').Muxer
+export type Capabilities = import('../../../lib/ffmpeg/convert').Capabilities
 
 export interface Metric {
   elapsedTime: number
@@ -45,6 +43,7 @@ export interface Metric {
   audioCodec: string
   wasm: boolean
   index: number
+  stats: JobStats | null
 }
 
 interface RunInfo {
@@ -54,18 +53,105 @@ interface RunInfo {
 
 export type FileRuntimeMap = Record<string, RunInfo>
 
+// Blobs are read in slices as the job goes, instead of being loaded whole
+export type InputData = ArrayBuffer | Blob
+
+export type ChunkCallback = (chunk: ArrayBuffer) => Promise<void> | void
+export type ProgressCallback = (progress: Progress) => Promise<void> | void
+
+const toModuleInput = (data: InputData) =>
+  data instanceof Blob ? createBlobReader(data) : new Uint8Array(data)
+
+const getInputSize = (data: InputData) =>
+  data instanceof Blob ? data.size : data.byteLength
+
+// The module blocks this worker until the job is done, so a cancellation can
+// only come in through memory shared with the main thread
+const createProgressHandler = (
+  onProgress?: ProgressCallback,
+  cancelFlag?: Int32Array
+) =>
+  onProgress || cancelFlag
+    ? (progress: Progress) => {
+        if (onProgress) {
+          onProgress(progress)
+        }
+
+        return !!cancelFlag && Atomics.load(cancelFlag, 0) !== 0
+      }
+    : undefined
+
 class FFmpeg {
   private _wasmModule: Promise<FFModule> | undefined
   private _asmModule: Promise<FFModule> | undefined
+  private _compiledWasm: WebAssembly.Module | undefined
+
+  constructor(compiledWasm?: WebAssembly.Module) {
+    this._compiledWasm = compiledWasm
+  }
 
+  // A module that can't be loaded leaves the worker unable to run any job
   private get wasm() {
+    return this.loadWasm().catch(err => {
+      throw createWorkerFailure(err)
+    })
+  }
+
+  private get asm() {
+    return this.loadAsm().catch(err => {
+      throw createWorkerFailure(err)
+    })
+  }
+
+  private loadWasm() {
+    const variant = selectBuildVariant()
+
+    if (!this._wasmModule && variant === 'threads') {
+      // The pthreads build is loaded from its URL instead of being bundled,
+      // because the threads it spawns need to import the same script.
+      this._wasmModule = Promise.all(
+        ['convert.js', 'convert.wasm', 'convert.worker.js'].map(file =>
+          importBuildFile('threads', file).then(url => url.default as string)
+        )
+      ).then(([scriptUrl, threadsWasmUrl, workerUrl]) => {
+        const scope = self as any
+
+        // a rebuilt instance comes from the same script
+        if (!scope.ffmpeg) {
+          scope.importScripts(scriptUrl)
+        }
+
+        return initEmscriptenModule(scope.ffmpeg as ModuleFactory<FFModule>, {
+          wasmUrl: threadsWasmUrl,
+          workerUrl,
+          mainScriptUrl: scriptUrl,
+          wasmModule: this._compiledWasm,
+        })
+      })
+    }
+
+    if (!this._wasmModule && (variant === 'simd' || variant === 'speed')) {
+      this._wasmModule = Promise.all([
+        importBuildFile(variant, 'convert.js'),
+        importBuildFile(variant, 'convert.wasm'),
+      ]).then(([script, wasm]) =>
+        initEmscriptenModule(script.default as ModuleFactory<FFModule>, {
+          wasmUrl: wasm.default,
+          wasmModule: this._compiledWasm,
+        })
+      )
+    }
+
     if (!this._wasmModule) {
       return new Promise<ModuleFactory<FFModule>>(resolve => {
         import(
           '../../../lib/ffmpeg/convert'
         ).then(({ default: defaultValue }) => resolve(defaultValue))
       }).then(instance => {
-        this._wasmModule = initEmscriptenModule(instance, { wasmUrl })
+        this._wasmModule = initEmscriptenModule(instance, {
+          wasmUrl,
+          wasmModule: this._compiledWasm,
+        })
 
         return this._wasmModule
       })
@@ -74,7 +160,7 @@ class FFmpeg {
     return this._wasmModule
   }
 
-  private get asm() {
+  private loadAsm() {
     if (!this._asmModule) {
       return new Promise<ModuleFactory<FFModule>>(resolve => {
         import(
@@ -90,128 +176,331 @@ class FFmpeg {
     return this._asmModule
   }
 
+  // A job that failed on its own (a bad input or option, a budget that was
+  // exceeded) was torn down by the transcoder and the module can be reused.
+  // Only a trap or an abort of the runtime leaves it unusable, and the next
+  // job then gets a fresh instance (the compiled code is kept).
+  private discardBrokenModule(err: any, wasm: boolean) {
+    if (!isRuntimeFailure(err)) {
+      return
+    }
+
+    if (!wasm) {
+      this._asmModule = undefined
+      return
+    }
+
+    const brokenModule = this._wasmModule
+
+    this._wasmModule = undefined
+
+    if (brokenModule) {
+      // the threads of the pthreads build would outlive the instance
+      brokenModule.then(
+        instance => instance.terminateThreads(),
+        () => undefined
+      )
+    }
+  }
+
   private _convert = async (
     instance: FFModule,
-    data: ArrayBuffer,
+    data: InputData,
     filename: string,
     opts: ConvertOptions,
     id: number,
-    wasm: boolean
+    wasm: boolean,
+    onChunk?: ChunkCallback,
+    onProgress?: ProgressCallback,
+    cancelFlag?: Int32Array
   ) => {
     try {
+      let outputSize = 0
+      const pendingChunks: Array<Promise<void> | void> = []
+
+      const handleChunk =
+        onChunk &&
+        ((chunk: Uint8Array) => {
+          outputSize += chunk.byteLength
+          pendingChunks.push(onChunk(transfer(chunk.buffer, [chunk.buffer])))
+        })
+
       const start = performance.now()
-      const resultView = instance.convert(new Uint8ClampedArray(data), opts)
+      const result = instance.convert(
+        toModuleInput(data),
+        {
+          ...opts,
+          onProgress: createProgressHandler(onProgress, cancelFlag),
+        },
+        handleChunk
+      )
       const end = performance.now()
 
+      // the chunks travel through their own message channel, make sure they
+      // all arrived before reporting the job as done
+      await Promise.all(pendingChunks)
+
       const elapsedTime = (end - start) / 1000
 
-      const result = new Uint8ClampedArray(resultView)
+      if (result) {
+        outputSize = result.byteLength
+      }
 
       const runtimeMetrics: Metric = {
         elapsedTime,
         file: filename,
-        inputSize: data.byteLength,
-        outputSize: result.byteLength,
+        inputSize: getInputSize(data),
+        outputSize,
         format: opts.outputFormat,
         videoCodec: opts.videoEncoder,
         audioCodec: opts.audioEncoder,
         index: id,
         wasm,
+        stats: instance.getStats(),
       }
 
-      return { data: result.buffer as ArrayBuffer, metrics: runtimeMetrics }
+      const resultBuffer = result ? (result.buffer as ArrayBuffer) : null
+
+      return transfer(
+        { data: resultBuffer, metrics: runtimeMetrics },
+        resultBuffer ? [resultBuffer] : []
+      )
     } catch (err) {
+      // a cancelled job is torn down cleanly, the module can be reused
+      if (isAbortError(err)) {
+        return { data: null, metrics: null }
+      }
+
       console.error(err)
 
-      return { data: null }
+      this.discardBrokenModule(err, wasm)
+
+      return { data: null, metrics: null }
     }
   }
 
   public convert = async (
     id: number,
-    data: ArrayBuffer,
+    data: InputData,
     filename: string,
-    opts: ConvertOptions
+    opts: ConvertOptions,
+    onChunk?: ChunkCallback,
+    onProgress?: ProgressCallback,
+    cancelFlag?: Int32Array
   ) => {
     const wasm = await this.wasm
 
-    return this._convert(wasm, data, filename, opts, id, true)
+    return this._convert(
+      wasm,
+      data,
+      filename,
+      opts,
+      id,
+      true,
+      onChunk,
+      onProgress,
+      cancelFlag
+    )
   }
 
   public convertAsm = async (
     id: number,
-    data: ArrayBuffer,
+    data: InputData,
     filename: string,
-    opts: ConvertOptions
+    opts: ConvertOptions,
+    onChunk?: ChunkCallback,
+    onProgress?: ProgressCallback,
+    cancelFlag?: Int32Array
   ) => {
     const asm = await this.asm
 
-    return this._convert(asm, data, filename, opts, id, false)
+    return this._convert(
+      asm,
+      data,
+      filename,
+      opts,
+      id,
+      false,
+      onChunk,
+      onProgress,
+      cancelFlag
+    )
   }
 
-  public listEncoders = async () => {
+  /**
+   * Converts the input to every one of `opts.outputs`, decoding it once for
+   * all of them. Only runs on the wasm build.
+   */
+  public convertMany = async (
+    id: number,
+    data: InputData,
+    filename: string,
+    opts: MultiConvertOptions,
+    onProgress?: ProgressCallback,
+    cancelFlag?: Int32Array
+  ) => {
     const wasm = await this.wasm
 
-    const codecsVector = wasm.list_encoders()
+    try {
+      const start = performance.now()
+      const results = wasm.convertMany(toModuleInput(data), {
+        ...opts,
+        onProgress: createProgressHandler(onProgress, cancelFlag),
+      }) as Uint8Array[]
+      const end = performance.now()
+
+      const resultBuffers = results.map(result => result.buffer as ArrayBuffer)
+      const outputs = opts.outputs.map(output => ({ ...opts, ...output }))
 
-    const codecs: Codec[] = []
+      const runtimeMetrics: Metric = {
+        elapsedTime: (end - start) / 1000,
+        file: filename,
+        inputSize: getInputSize(data),
+        outputSize: results.reduce(
+          (size, result) => size + result.byteLength,
+          0
+        ),
+        format: outputs.map(output => output.outputFormat).join(','),
+        videoCodec: outputs.map(output => output.videoEncoder).join(','),
+        audioCodec: outputs.map(output => output.audioEncoder).join(','),
+        index: id,
+        wasm: true,
+        stats: wasm.getStats(),
+      }
 
-    for (let i = 0; i < codecsVector.size(); i++) {
-      const rawCodec = codecsVector.get(i)
+      return transfer(
+        { data: resultBuffers, metrics: runtimeMetrics },
+        resultBuffers
+      )
+    } catch (err) {
+      if (!isAbortError(err)) {
+        console.error(err)
 
-      if (
-        !rawCodec.id ||
-        codecs.findIndex(codec => codec.id === rawCodec.id.value) > -1
-      ) {
-        continue
+        this.discardBrokenModule(err, true)
       }
 
-      codecs.push({
-        id: rawCodec.id.value,
-        name: rawCodec.name,
-        capabilities: {
-          drawHorizBand: !!(
-            rawCodec.capabilities & wasm.AV_CODEC_CAP_DRAW_HORIZ_BAND
-          ),
-          dr1: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_DR1),
-          truncated: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_TRUNCATED),
-          delay: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_DELAY),
-          subFrames: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_SUBFRAMES),
-          experimental: !!(
-            rawCodec.capabilities & wasm.AV_CODEC_CAP_EXPERIMENTAL
-          ),
-          intraOnly: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_INTRA_ONLY),
-          lossless: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_LOSSLESS),
-          hardware: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_HARDWARE),
-          hybrid: !!(rawCodec.capabilities & wasm.AV_CODEC_CAP_HYBRID),
-        },
-        longName: rawCodec.long_name,
-        type: rawCodec.type.value,
-      })
+      return { data: null, metrics: null }
     }
+  }
+
+  public probe = async (data: InputData, opts?: ProbeOptions) => {
+    const wasm = await this.wasm
+
+    try {
+      return wasm.probe(toModuleInput(data), opts)
+    } catch (err) {
+      console.error(err)
 
-    return codecs
+      return null
+    }
   }
 
-  public listMuxers = async () => {
+  public thumbnails = async (data: InputData, opts?: ThumbnailOptions) => {
     const wasm = await this.wasm
 
-    const muxerVector = wasm.list_muxers()
+    try {
+      const thumbnails = wasm.thumbnails(toModuleInput(data), opts)
 
-    const muxers: Muxer[] = []
+      return transfer(
+        thumbnails,
+        thumbnails.map(thumbnail => thumbnail.data.buffer)
+      )
+    } catch (err) {
+      console.error(err)
 
-    for (let i = 0; i < muxerVector.size(); i++) {
-      const rawMuxer = muxerVector.get(i)
+      return []
+    }
+  }
 
-      muxers.push({
-        name: rawMuxer.name,
-        longName: rawMuxer.long_name,
-        mimeType: rawMuxer.mime_type,
-        extensions: rawMuxer.extensions.split(','),
-        audioCodec: rawMuxer.audio_codec && rawMuxer.audio_codec.value,
-        videoCodec: rawMuxer.video_codec && rawMuxer.video_codec.value,
+  /**
+   * The concrete preset, and the size it may have to scale down to, that
+   * `preset: 'auto'` resolves to for this input. Resolves to null when the
+   * input can't be read or the job was cancelled.
+   */
+  public resolvePreset = async (
+    data: InputData,
+    opts: ConvertOptions,
+    cancelFlag?: Int32Array
+  ) => {
+    const wasm = await this.wasm
+
+    try {
+      const { preset, maxHeight } = wasm.resolvePreset(toModuleInput(data), {
+        ...opts,
+        onProgress: createProgressHandler(undefined, cancelFlag),
       })
+
+      return { preset, maxHeight }
+    } catch (err) {
+      if (!isAbortError(err)) {
+        console.error(err)
+
+        this.discardBrokenModule(err, true)
+      }
+
+      return null
     }
+  }
+
+  public planSegments = async (data: InputData, count: number) => {
+    const wasm = await this.wasm
+
+    try {
+      return wasm.planSegments(toModuleInput(data), count)
+    } catch (err) {
+      console.error(err)
+
+      return []
+    }
+  }
+
+  public concat = async (
+    segments: ArrayBuffer[],
+    cuts: number[],
+    opts: ConvertOptions,
+    cancelFlag?: Int32Array
+  ) => {
+    const wasm = await this.wasm
+
+    try {
+      const result = wasm.concat(
+        segments.map(segment => new Uint8Array(segment)),
+        cuts,
+        {
+          ...opts,
+          onProgress: cancelFlag
+            ? () => Atomics.load(cancelFlag, 0) !== 0
+            : undefined,
+        }
+      ) as Uint8Array
+      const resultBuffer = result.buffer as ArrayBuffer
+
+      return transfer(resultBuffer, [resultBuffer])
+    } catch (err) {
+      if (!isAbortError(err)) {
+        console.error(err)
+
+        this.discardBrokenModule(err, true)
+      }
+
+      return null
+    }
+  }
+
+  public getCapabilities = async (): Promise<Capabilities> => {
+    const wasm = await this.wasm
+
+    return wasm.getCapabilities()
+  }
+
+  public listEncoders = async () => {
+    const { encoders } = await this.getCapabilities()
+
+    return encoders
+  }
+
+  public listMuxers = async () => {
+    const { muxers } = await this.getCapabilities()
 
     return muxers
   }